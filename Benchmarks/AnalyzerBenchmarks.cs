@@ -0,0 +1,105 @@
+﻿using BenchmarkDotNet.Attributes;
+using cppcx.Benchmarks.Corpus;
+using cppcx.Core.Analyzers;
+using cppcx.Core.Helpers;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Benchmarks
+{
+    [Config(typeof(BenchmarkConfig))]
+    public class AnalyzerBenchmarks
+    {
+        private CPPCXParser.TranslationUnitContext _tu;
+        private List<CPPCXParser.DeclarationseqContext> _namespaceBodies;
+        private List<CPPCXParser.SimpleDeclarationContext> _variables;
+        private List<CPPCXParser.SimpleDeclarationContext> _functions;
+
+        [Params(64, 1024, 4096)]
+        public int SizeKB { get; set; }
+
+        [Params(CorpusKind.Header, CorpusKind.Source)]
+        public CorpusKind Kind { get; set; }
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            var parsed = new CxParserWorker().Parse(new CxSourceText(BenchmarkCorpus.Get(Kind, SizeKB), "Generated.xaml"));
+            _tu = parsed.TranslationUnit;
+
+            var analysis = new TranslationUnitAnalyzer().Visit(_tu);
+            _namespaceBodies = new List<CPPCXParser.DeclarationseqContext> { _tu.declarationseq() };
+            CollectBodies(analysis.Root, _namespaceBodies);
+            _variables = analysis.Bodies.SelectMany(o => o.Body.GlobalVariables).Select(o => o.Context).ToList();
+            _functions = analysis.Bodies.SelectMany(o => o.Body.FunctionDeclarations).Select(o => o.Context).ToList();
+        }
+
+        private static void CollectBodies(NamespaceAnalyzer.Namespace ns, List<CPPCXParser.DeclarationseqContext> res)
+        {
+            res.AddRange(ns.Contexts.Where(o => o != null));
+            foreach (var nested in ns.NestedNamespaces.Values)
+            {
+                CollectBodies(nested, res);
+            }
+        }
+
+        [Benchmark]
+        public NamespaceAnalyzer.Namespace Namespaces()
+        {
+            return new NamespaceAnalyzer().Visit(_tu);
+        }
+
+        [Benchmark]
+        public int NamespaceBodies()
+        {
+            var res = 0;
+            foreach (var body in _namespaceBodies)
+            {
+                res += new NamespaceBodyAnalyzer().Visit(body)?.FunctionDefinitions.Count ?? 0;
+            }
+            return res;
+        }
+
+        [Benchmark]
+        public int GlobalVariables()
+        {
+            var analyzer = new GlobalVariableAnalyzer();
+            var res = 0;
+            foreach (var variable in _variables)
+            {
+                res += analyzer.Visit(variable).Count();
+            }
+            return res;
+        }
+
+        [Benchmark]
+        public int FunctionDeclarations()
+        {
+            var analyzer = new FunctionDeclarationAnalyzer();
+            var res = 0;
+            foreach (var function in _functions)
+            {
+                res += analyzer.Visit(function).Parameters.Count;
+            }
+            return res;
+        }
+
+        [Benchmark]
+        public CxNamespace Model()
+        {
+            return new CxModelAnalyzer { Detached = true }.Visit(_tu);
+        }
+
+        [Benchmark]
+        public void Printer()
+        {
+            new CPPCXPrinter(TextWriter.Null).Print(_tu);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+﻿using BenchmarkDotNet.Columns;
+using BenchmarkDotNet.Configs;
+using BenchmarkDotNet.Diagnosers;
+using BenchmarkDotNet.Reports;
+using BenchmarkDotNet.Running;
+using cppcx.Benchmarks.Corpus;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Benchmarks
+{
+    public class BenchmarkConfig : ManualConfig
+    {
+        public BenchmarkConfig()
+        {
+            AddDiagnoser(MemoryDiagnoser.Default);
+            AddColumn(new ThroughputColumn());
+        }
+    }
+
+    // Input MB/s, from the SizeKB and Kind parameters every benchmark class has.
+    public class ThroughputColumn : IColumn
+    {
+        public string Id => nameof(ThroughputColumn);
+        public string ColumnName => "MB/s";
+        public bool AlwaysShow => true;
+        public ColumnCategory Category => ColumnCategory.Custom;
+        public int PriorityInCategory => 0;
+        public bool IsNumeric => true;
+        public UnitType UnitType => UnitType.Dimensionless;
+        public string Legend => "Megabytes of input processed per second";
+
+        public bool IsAvailable(Summary summary) => true;
+        public bool IsDefault(Summary summary, BenchmarkCase benchmarkCase) => false;
+
+        public string GetValue(Summary summary, BenchmarkCase benchmarkCase)
+        {
+            return GetValue(summary, benchmarkCase, SummaryStyle.Default);
+        }
+
+        public string GetValue(Summary summary, BenchmarkCase benchmarkCase, SummaryStyle style)
+        {
+            var statistics = summary[benchmarkCase]?.ResultStatistics;
+            if (statistics == null
+                || benchmarkCase.Parameters["SizeKB"] is not int sizeKB
+                || benchmarkCase.Parameters["Kind"] is not CorpusKind kind)
+            {
+                return "-";
+            }
+
+            var megabytes = BenchmarkCorpus.Get(kind, sizeKB).Length / (1024.0 * 1024.0);
+            return (megabytes / (statistics.Mean / 1e9)).ToString("F2");
+        }
+
+        public override string ToString() => ColumnName;
+    }
+}
@@ -0,0 +1,24 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Benchmarks.Corpus
+{
+    public enum CorpusKind
+    {
+        Header, Source
+    }
+
+    public static class BenchmarkCorpus
+    {
+        private static readonly ConcurrentDictionary<(CorpusKind, int), string> _texts = new ConcurrentDictionary<(CorpusKind, int), string>();
+
+        public static string Get(CorpusKind kind, int sizeKB)
+        {
+            return _texts.GetOrAdd((kind, sizeKB), key => CorpusGenerator.ForSize(key.Item1, key.Item2 * 1024).Generate(key.Item1));
+        }
+    }
+}
@@ -0,0 +1,237 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Benchmarks.Corpus
+{
+    // Generates C++/CX in the style of App.xaml.h/App.xaml.cpp: nested namespaces with
+    // resource keys and free functions, ref classes with members of every visibility, and
+    // out-of-line definitions with long bodies.
+    public class CorpusGenerator
+    {
+        public int NamespaceDepth { get; init; } = 3;
+        public int Classes { get; init; } = 8;
+        public int MethodsPerClass { get; init; } = 12;
+        public int FieldsPerClass { get; init; } = 6;
+        public int GlobalsPerNamespace { get; init; } = 4;
+        public int StatementsPerBody { get; init; } = 24;
+        public int Seed { get; init; } = 1;
+
+        public static CorpusGenerator ForSize(CorpusKind kind, int targetBytes, int seed = 1)
+        {
+            // Both kinds grow linearly with the class count, but a header class is much smaller
+            // than its definitions, so each kind is probed on its own. Two probes separate the
+            // per-class size from the fixed namespace and include overhead.
+            var one = new CorpusGenerator { Classes = 1, Seed = seed }.Generate(kind).Length;
+            var two = new CorpusGenerator { Classes = 2, Seed = seed }.Generate(kind).Length;
+            var perClass = Math.Max(1, two - one);
+            var overhead = one - perClass;
+            return new CorpusGenerator { Classes = Math.Max(1, (targetBytes - overhead) / perClass), Seed = seed };
+        }
+
+        public string Generate(CorpusKind kind)
+        {
+            return kind == CorpusKind.Header ? GenerateHeader() : GenerateSource();
+        }
+
+        private IEnumerable<string> NamespaceNames => Enumerable.Range(0, NamespaceDepth).Select(o => $"Level{o}");
+        private string QualifiedNamespace => string.Join("::", NamespaceNames);
+
+        public string GenerateHeader()
+        {
+            var sb = new StringBuilder();
+            sb.AppendLine("#pragma once");
+            sb.AppendLine();
+            sb.AppendLine("#include \"pch.h\"");
+            sb.AppendLine();
+            sb.AppendLine($"namespace Generated::{QualifiedNamespace}");
+            sb.AppendLine("{");
+
+            sb.AppendLine("    namespace ResourceKeys");
+            sb.AppendLine("    {");
+            for (int i = 0; i < GlobalsPerNamespace; ++i)
+            {
+                sb.AppendLine($"        extern Platform::StringReference Key{i};");
+            }
+            sb.AppendLine("        int counter, limit = 3;");
+            sb.AppendLine();
+            for (int i = 0; i < GlobalsPerNamespace; ++i)
+            {
+                sb.AppendLine($"        Windows::Foundation::Size GetSize{i}(int viewId, Platform::String^ name);");
+            }
+            sb.AppendLine("    }");
+
+            for (int c = 0; c < Classes; ++c)
+            {
+                sb.AppendLine();
+                sb.AppendLine($"    ref class Class{c} sealed");
+                sb.AppendLine("    {");
+                sb.AppendLine("    public:");
+                sb.AppendLine($"        Class{c}();");
+                sb.AppendLine("        virtual void OnLaunched(Windows::ApplicationModel::Activation::LaunchActivatedEventArgs^ args) override;");
+                for (int m = 0; m < MethodsPerClass; ++m)
+                {
+                    if (m == MethodsPerClass / 3) sb.AppendLine("\n    internal:");
+                    if (m == 2 * MethodsPerClass / 3) sb.AppendLine("\n    private:");
+                    var isStatic = m % 5 == 4 ? "static " : "";
+                    sb.AppendLine($"        {isStatic}{ReturnType(m)} Method{m}(int viewId, _In_ WindowFrameService^ frameService, Platform::String^ name);");
+                }
+
+                sb.AppendLine();
+                sb.AppendLine("        class Guard final");
+                sb.AppendLine("        {");
+                sb.AppendLine("        public:");
+                sb.AppendLine($"            Guard(Class{c}^ parent)");
+                sb.AppendLine("                : m_parent(parent)");
+                sb.AppendLine("                , m_released(false)");
+                sb.AppendLine("            {");
+                sb.AppendLine("            }");
+                sb.AppendLine();
+                sb.AppendLine("            void Release(bool released)");
+                sb.AppendLine("            {");
+                sb.AppendLine("                m_released = released;");
+                sb.AppendLine("            }");
+                sb.AppendLine();
+                sb.AppendLine("        private:");
+                sb.AppendLine($"            Class{c}^ m_parent;");
+                sb.AppendLine("            bool m_released;");
+                sb.AppendLine("        };");
+                sb.AppendLine();
+                sb.AppendLine("    private:");
+                for (int f = 0; f < FieldsPerClass; ++f)
+                {
+                    sb.AppendLine(f % 2 == 0
+                        ? $"        int m_value{f};"
+                        : $"        std::unordered_map<int, WindowFrameService^> m_windows{f};");
+                }
+                sb.AppendLine("    };");
+            }
+
+            sb.AppendLine("}");
+            return sb.ToString();
+        }
+
+        public string GenerateSource()
+        {
+            var random = new Random(Seed);
+            var sb = new StringBuilder();
+            sb.AppendLine("#include \"pch.h\"");
+            sb.AppendLine("#include \"Generated.xaml.h\"");
+            sb.AppendLine();
+            sb.AppendLine("using namespace concurrency;");
+            sb.AppendLine("using namespace Platform;");
+            sb.AppendLine($"using namespace Generated::{QualifiedNamespace};");
+            sb.AppendLine();
+
+            var indent = "";
+            sb.AppendLine("namespace Generated");
+            sb.AppendLine("{");
+            foreach (var name in NamespaceNames)
+            {
+                indent += "    ";
+                sb.AppendLine($"{indent}namespace {name}");
+                sb.AppendLine($"{indent}{{");
+            }
+            sb.AppendLine($"{indent}    namespace ResourceKeys");
+            sb.AppendLine($"{indent}    {{");
+            for (int i = 0; i < GlobalsPerNamespace; ++i)
+            {
+                sb.AppendLine($"{indent}        StringReference Key{i}(L\"Key{i}\");");
+            }
+            sb.AppendLine($"{indent}    }}");
+            for (; indent.Length > 0; indent = indent[4..])
+            {
+                sb.AppendLine($"{indent}}}");
+            }
+            sb.AppendLine("}");
+
+            for (int c = 0; c < Classes; ++c)
+            {
+                sb.AppendLine();
+                sb.AppendLine($"Class{c}::Class{c}()");
+                sb.AppendLine("{");
+                sb.AppendLine("    InitializeComponent();");
+                sb.AppendLine();
+                sb.AppendLine($"    this->Suspending += ref new SuspendingEventHandler(this, &Class{c}::OnSuspending);");
+                sb.AppendLine("}");
+
+                sb.AppendLine();
+                sb.AppendLine($"void Class{c}::OnLaunched(LaunchActivatedEventArgs ^ args)");
+                sb.AppendLine("{");
+                AppendStatements(sb, random, "    ");
+                sb.AppendLine("}");
+
+                for (int m = 0; m < MethodsPerClass; ++m)
+                {
+                    sb.AppendLine();
+                    sb.AppendLine($"{ReturnType(m)} Class{c}::Method{m}(int viewId, _In_ WindowFrameService ^ frameService, String ^ name)");
+                    sb.AppendLine("{");
+                    AppendStatements(sb, random, "    ");
+                    sb.AppendLine(m % 3 == 0 ? "" : m % 3 == 1 ? "    return nullptr;" : "    return viewId;");
+                    sb.AppendLine("}");
+                }
+            }
+
+            return sb.ToString();
+        }
+
+        private static string ReturnType(int method)
+        {
+            return (method % 3) switch
+            {
+                0 => "void",
+                1 => "WindowFrameService ^",
+                _ => "int",
+            };
+        }
+
+        private void AppendStatements(StringBuilder sb, Random random, string indent)
+        {
+            for (int i = 0; i < StatementsPerBody; ++i)
+            {
+                switch (random.Next(8))
+                {
+                    case 0:
+                        sb.AppendLine($"{indent}reader_writer_lock::scoped_lock lock{i}(m_windowsMapLock);");
+                        break;
+                    case 1:
+                        sb.AppendLine($"{indent}auto iter{i} = m_secondaryWindows.find(viewId + {i});");
+                        sb.AppendLine($"{indent}if (iter{i} != m_secondaryWindows.end())");
+                        sb.AppendLine($"{indent}{{");
+                        sb.AppendLine($"{indent}    m_secondaryWindows.erase(viewId);");
+                        sb.AppendLine($"{indent}}}");
+                        break;
+                    case 2:
+                        sb.AppendLine($"{indent}// Shell does not allow killing the main window.");
+                        sb.AppendLine($"{indent}TraceLogger::GetInstance()->UpdateWindowCount(m_secondaryWindows.size() + {i});");
+                        break;
+                    case 3:
+                        sb.AppendLine($"{indent}for (int i = 0; i < {random.Next(1, 100)}; ++i)");
+                        sb.AppendLine($"{indent}{{");
+                        sb.AppendLine($"{indent}    m_total += i * {i} - (viewId >> 2);");
+                        sb.AppendLine($"{indent}}}");
+                        break;
+                    case 4:
+                        sb.AppendLine($"{indent}auto frame{i} = safe_cast<Frame ^>(Window::Current->Content);");
+                        sb.AppendLine($"{indent}frame{i}->FlowDirection = LocalizationService::GetInstance()->GetFlowDirection();");
+                        break;
+                    case 5:
+                        sb.AppendLine($"{indent}this->HighContrastAdjustment = ApplicationHighContrastAdjustment::None;");
+                        break;
+                    case 6:
+                        sb.AppendLine($"{indent}frameService->HandleViewRelease().then(");
+                        sb.AppendLine($"{indent}    [this, frameService]() {{");
+                        sb.AppendLine($"{indent}        RemoveWindowFromMap(frameService->GetViewId());");
+                        sb.AppendLine($"{indent}    }},");
+                        sb.AppendLine($"{indent}    task_continuation_context::use_arbitrary());");
+                        break;
+                    default:
+                        sb.AppendLine($"{indent}auto item{i} = ref new Uri(\"ms-appx:///Assets/\" + name + \".png\");");
+                        break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,40 @@
+﻿using BenchmarkDotNet.Attributes;
+using cppcx.Benchmarks.Corpus;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Benchmarks
+{
+    [Config(typeof(BenchmarkConfig))]
+    public class LexerBenchmarks
+    {
+        private CxSourceText _source;
+        private CPPCXLexer _lexer;
+
+        [Params(64, 1024, 4096)]
+        public int SizeKB { get; set; }
+
+        [Params(CorpusKind.Header, CorpusKind.Source)]
+        public CorpusKind Kind { get; set; }
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _source = new CxSourceText(BenchmarkCorpus.Get(Kind, SizeKB), "Generated.xaml");
+            _lexer = new CPPCXLexer(null);
+            _lexer.RemoveErrorListeners();
+        }
+
+        [Benchmark]
+        public int Tokenize()
+        {
+            _source.Seek(0);
+            _lexer.SetInputStream(_source);
+            return _lexer.GetAllTokens().Count;
+        }
+    }
+}
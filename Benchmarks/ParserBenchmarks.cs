@@ -0,0 +1,58 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Atn;
+using BenchmarkDotNet.Attributes;
+using cppcx.Benchmarks.Corpus;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Benchmarks
+{
+    [Config(typeof(BenchmarkConfig))]
+    public class ParserBenchmarks
+    {
+        private CxSourceText _source;
+        private IList<IToken> _tokens;
+        private CPPCXParser _parser;
+        private CxParserWorker _worker;
+
+        [Params(64, 1024, 4096)]
+        public int SizeKB { get; set; }
+
+        [Params(CorpusKind.Header, CorpusKind.Source)]
+        public CorpusKind Kind { get; set; }
+
+        [GlobalSetup]
+        public void Setup()
+        {
+            _source = new CxSourceText(BenchmarkCorpus.Get(Kind, SizeKB), "Generated.xaml");
+
+            // Tokens are produced once, so TranslationUnit measures the parser alone.
+            var lexer = new CPPCXLexer(_source);
+            lexer.RemoveErrorListeners();
+            _tokens = lexer.GetAllTokens();
+
+            _parser = new CPPCXParser(null);
+            _parser.RemoveErrorListeners();
+            _worker = new CxParserWorker();
+        }
+
+        [Benchmark]
+        public CPPCXParser.TranslationUnitContext TranslationUnit()
+        {
+            _parser.TokenStream = new CommonTokenStream(new ListTokenSource(_tokens, _source.SourceName));
+            _parser.Interpreter.PredictionMode = PredictionMode.LL;
+            return _parser.translationUnit();
+        }
+
+        [Benchmark]
+        public CxParseResult LexAndParseTwoStage()
+        {
+            _source.Seek(0);
+            return _worker.Parse(_source);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+﻿using BenchmarkDotNet.Running;
+using cppcx.Benchmarks.Corpus;
+using System;
+using System.IO;
+
+namespace cppcx.Benchmarks
+{
+    class Program
+    {
+        static int Main(string[] args)
+        {
+            if (args.Length > 0 && args[0] == "generate")
+            {
+                return Generate(args[1..]);
+            }
+
+            BenchmarkSwitcher.FromAssembly(typeof(Program).Assembly).Run(args);
+            return 0;
+        }
+
+        // Writes a corpus for end-to-end runs, e.g. `cppcx_parser batch <dir>`.
+        static int Generate(string[] args)
+        {
+            string output = null;
+            var sizeKB = 1024;
+            var files = 1;
+
+            for (int i = 0; i < args.Length; ++i)
+            {
+                switch (args[i])
+                {
+                    case "--size":
+                        sizeKB = int.Parse(args[++i]);
+                        break;
+                    case "--files":
+                        files = int.Parse(args[++i]);
+                        break;
+                    default:
+                        output = args[i];
+                        break;
+                }
+            }
+
+            if (output == null)
+            {
+                Console.Error.WriteLine("Usage: Benchmarks generate [--size KB] [--files N] <dir>");
+                return 1;
+            }
+
+            Directory.CreateDirectory(output);
+            for (int i = 0; i < files; ++i)
+            {
+                var header = CorpusGenerator.ForSize(CorpusKind.Header, sizeKB * 1024, seed: i + 1);
+                var source = CorpusGenerator.ForSize(CorpusKind.Source, sizeKB * 1024, seed: i + 1);
+                File.WriteAllText(Path.Combine(output, $"Generated{i}.xaml.h"), header.GenerateHeader());
+                File.WriteAllText(Path.Combine(output, $"Generated{i}.xaml.cpp"), source.GenerateSource());
+            }
+
+            Console.WriteLine($"Wrote {files * 2} files to {output}");
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,109 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using UnitTest.Utils;
+using Xunit;
+
+namespace UnitTest.AnalyzerTests
+{
+    public class CxModelAnalyzerTest
+    {
+        private static CxNamespace GetNamespace(CxNamespace root, string qualifiedName)
+        {
+            var current = root;
+            foreach (var part in qualifiedName.Split("::"))
+            {
+                current = current.NestedNamespaces.Single(o => o.Namespace == part);
+            }
+            return current;
+        }
+
+        [Fact]
+        public void TestHeader()
+        {
+            var root = new CxModelAnalyzer().Visit(CxParser.Parse("data/App.xaml.h"));
+
+            var keys = GetNamespace(root, "Calculator::App::ApplicationResourceKeys");
+            Assert.Equal(new[] { "AppMinWindowHeight", "AppMinWindowWidth", "a", "b" }, keys.GlobalVariables.Select(o => o.TypedName.Name));
+            Assert.Equal(new[] { true, true, false, false }, keys.GlobalVariables.Select(o => o.IsExtern));
+            Assert.Equal(new[] { "f", "g", "h" }, keys.Functions.Select(o => o.Name));
+            Assert.Equal("Windows::ApplicationModel::Activation::LaunchActivatedEventArgs", keys.Functions[2].ReturnType.Name);
+
+            var app = Assert.Single(GetNamespace(root, "Calculator::App").Classes);
+            Assert.Equal("App", app.Name);
+            Assert.True(app.IsSealed);
+            Assert.NotEmpty(app.Functions);
+
+            var nested = Assert.Single(app.NestedClasses);
+            Assert.Equal("SafeFrameWindowCreation", nested.Name);
+            Assert.True(nested.IsFinal);
+        }
+
+        [Fact]
+        public void TestSource()
+        {
+            var root = new CxModelAnalyzer().Visit(CxParser.Parse("data/App.xaml.cpp"));
+
+            Assert.Equal(16, root.Functions.Count);
+            Assert.All(root.Functions, o => Assert.NotNull(o.Code));
+
+            var keys = GetNamespace(root, "CalculatorApp::ApplicationResourceKeys");
+            Assert.Equal(new[] { "AppMinWindowHeight", "AppMinWindowWidth" }, keys.GlobalVariables.Select(o => o.TypedName.Name));
+        }
+
+        [Fact]
+        public void TestDetached()
+        {
+            var attached = new CxModelAnalyzer().Visit(CxParser.Parse("data/App.xaml.cpp"));
+            var detached = new CxModelAnalyzer { Detached = true }.Visit(CxParser.Parse("data/App.xaml.cpp"));
+
+            Assert.Equal(attached.Functions.Count, detached.Functions.Count);
+            for (int i = 0; i < attached.Functions.Count; ++i)
+            {
+                var expected = attached.Functions[i].Code;
+                var actual = detached.Functions[i].Code;
+
+                Assert.False(expected.IsDetached);
+                Assert.True(actual.IsDetached);
+                Assert.Equal(expected.Span, actual.Span);
+
+                var reparsed = actual.GetContext();
+                Assert.IsType<CPPCXParser.FunctionBodyContext>(reparsed);
+                Assert.Equal(expected.Context.GetText(), reparsed.GetText());
+                Assert.Equal(expected.Context.Start.Line, reparsed.Start.Line);
+            }
+        }
+
+        [Fact]
+        public void TestDetachedRejectsChangedSource()
+        {
+            var copy = Path.Combine(Path.GetTempPath(), $"cppcx_detached_{Guid.NewGuid():N}.cpp");
+            File.Copy("data/App.xaml.cpp", copy);
+            try
+            {
+                var code = new CxModelAnalyzer { Detached = true }.Visit(CxParser.Parse(copy)).Functions.First(o => o.Code != null).Code;
+                Assert.IsType<CPPCXParser.FunctionBodyContext>(code.GetContext());
+
+                File.WriteAllText(copy, "// edited\n" + File.ReadAllText("data/App.xaml.cpp"));
+                Assert.Throws<InvalidOperationException>(() => code.GetContext());
+
+                File.Delete(copy);
+                Assert.Throws<InvalidOperationException>(() => code.GetContext());
+            }
+            finally
+            {
+                File.Delete(copy);
+            }
+
+            var source = new CxSourceText(File.ReadAllText("data/App.xaml.cpp"));
+            var inMemory = new CxModelAnalyzer { Detached = true }.Visit(new CxParserWorker().Parse(source).TranslationUnit);
+            Assert.Throws<InvalidOperationException>(() => inMemory.Functions.First(o => o.Code != null).Code.GetContext());
+        }
+    }
+}
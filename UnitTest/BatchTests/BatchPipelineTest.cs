@@ -0,0 +1,56 @@
+﻿using cppcx.Core.Batch;
+using cppcx.Core.Caching;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.BatchTests
+{
+    public class BatchPipelineTest
+    {
+        [Theory]
+        [InlineData(1)]
+        [InlineData(4)]
+        public void Test(int queueCapacity)
+        {
+            var files = new[] { "data/App.xaml.h", "data/App.xaml.cpp", "data/App.xaml.h", "data/App.xaml.cpp" };
+            var expected = new BatchRunner().Run(files);
+            var pipeline = new BatchPipeline(new BatchPipeline.Options
+            {
+                QueueCapacity = queueCapacity,
+                ReadParallelism = 2,
+                LexParallelism = 1,
+                ParseParallelism = 2,
+                AnalyzeParallelism = 1,
+            });
+
+            var completed = 0;
+            var result = pipeline.Run(files, _ => System.Threading.Interlocked.Increment(ref completed));
+
+            Assert.Equal(files.Length, completed);
+            Assert.Equal(expected.Files.Select(o => (o.Path, o.Declarations, o.SyntaxErrors)), result.Files.Select(o => (o.Path, o.Declarations, o.SyntaxErrors)));
+            Assert.Equal(new[] { "read", "lex", "parse", "analyze" }, result.Stages.Select(o => o.Name));
+            Assert.All(result.Stages, o => Assert.Equal(files.Length, o.Items));
+            Assert.All(result.Stages, o => Assert.InRange(o.MaxQueueLength, 0, queueCapacity));
+        }
+
+        [Fact]
+        public void TestMissingFile()
+        {
+            var result = new BatchPipeline().Run(new[] { "data/App.xaml.h", "data/missing.cpp" });
+
+            Assert.Null(result.Files.Single(o => o.Path.EndsWith("App.xaml.h")).Exception);
+            Assert.NotNull(result.Files.Single(o => o.Path.EndsWith("missing.cpp")).Exception);
+        }
+
+        [Fact]
+        public void TestRejectsUnsupportedOptions()
+        {
+            Assert.Throws<ArgumentException>(() => new BatchPipeline(new BatchPipeline.Options { MapFiles = true }));
+            Assert.Throws<ArgumentException>(() => new BatchPipeline(new BatchPipeline.Options { HeaderCache = new HeaderModelCache() }));
+        }
+    }
+}
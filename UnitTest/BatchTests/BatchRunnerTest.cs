@@ -0,0 +1,31 @@
+﻿using cppcx.Core.Batch;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.BatchTests
+{
+    public class BatchRunnerTest
+    {
+        [Theory]
+        [InlineData(1)]
+        [InlineData(4)]
+        public void Test(int workers)
+        {
+            var files = new[] { "data/App.xaml.h", "data/App.xaml.cpp" };
+            var runner = new BatchRunner(new BatchRunner.Options { MaxDegreeOfParallelism = workers });
+
+            var completed = 0;
+            var result = runner.Run(files, _ => System.Threading.Interlocked.Increment(ref completed));
+
+            Assert.Equal(files.Length, completed);
+            Assert.Equal(files.Length, result.Files.Count);
+            Assert.All(result.Files, o => Assert.Null(o.Exception));
+            Assert.All(result.Files, o => Assert.True(o.Declarations > 0));
+            Assert.True(result.TotalBytes > 0);
+        }
+    }
+}
@@ -0,0 +1,111 @@
+﻿using cppcx.Core.Caching;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.CachingTests
+{
+    public class HeaderModelCacheTest
+    {
+        private static CxClass GetApp(CxNamespace root)
+        {
+            return root.NestedNamespaces.Single(o => o.Namespace == "Calculator")
+                .NestedNamespaces.Single(o => o.Namespace == "App")
+                .Classes.Single();
+        }
+
+        // SafeFrameWindowCreation::SetOperationSuccess
+        private static CxCode GetCode(CxNamespace root)
+        {
+            return GetApp(root).NestedClasses.Single().Functions.First(o => o.Function.Code != null).Function.Code;
+        }
+
+        [Fact]
+        public void TestSharedAcrossWorkers()
+        {
+            var cache = new HeaderModelCache();
+
+            var models = Enumerable.Range(0, 8)
+                .AsParallel()
+                .Select(_ => cache.GetOrAnalyze("data/App.xaml.h", new CxParserWorker()))
+                .ToList();
+
+            Assert.Equal(1, cache.Count);
+            Assert.Equal(1, cache.Misses);
+            Assert.Equal(7, cache.Hits);
+            Assert.All(models, o => Assert.Same(models[0], o));
+        }
+
+        [Fact]
+        public void TestCopiedPerPath()
+        {
+            var copy = Path.Combine(Path.GetTempPath(), $"cppcx_header_{Guid.NewGuid():N}.h");
+            File.Copy("data/App.xaml.h", copy);
+            try
+            {
+                var cache = new HeaderModelCache();
+                var original = cache.GetOrAnalyze("data/App.xaml.h", new CxParserWorker());
+                var other = cache.GetOrAnalyze(copy, new CxParserWorker(), out var cached);
+
+                Assert.True(cached);
+                Assert.Equal(1, cache.Misses);
+                Assert.NotSame(original, other);
+                Assert.Equal("data/App.xaml.h", GetCode(original).SourceName);
+                Assert.Equal(copy, GetCode(other).SourceName);
+                Assert.Same(other, cache.GetOrAnalyze(copy, new CxParserWorker()));
+            }
+            finally
+            {
+                File.Delete(copy);
+            }
+        }
+
+        [Fact]
+        public void TestFailedAnalysisIsRetried()
+        {
+            var cache = new HeaderModelCache();
+
+            Assert.Throws<InvalidOperationException>(() => cache.GetOrAnalyze("data/App.xaml.h", _ => throw new InvalidOperationException(), out _));
+            Assert.Equal(0, cache.Count);
+
+            var model = cache.GetOrAnalyze("data/App.xaml.h", _ => new CxNamespace(), out var cached);
+            Assert.False(cached);
+            Assert.NotNull(model);
+        }
+
+        [Fact]
+        public void TestPersisted()
+        {
+            var dir = Path.Combine(Path.GetTempPath(), $"cppcx_cache_{Guid.NewGuid():N}");
+            try
+            {
+                var expected = new HeaderModelCache(dir).GetOrAnalyze("data/App.xaml.h", new CxParserWorker());
+
+                var cache = new HeaderModelCache(dir);
+                var actual = cache.GetOrAnalyze("data/App.xaml.h", new CxParserWorker(), out var cached);
+
+                Assert.True(cached);
+                Assert.Equal(1, cache.DiskHits);
+                Assert.Equal(0, cache.Misses);
+
+                var expectedClass = GetApp(expected);
+                var actualClass = GetApp(actual);
+                Assert.Equal(expectedClass.Name, actualClass.Name);
+                Assert.Equal(expectedClass.Fields.Select(o => o.TypedName), actualClass.Fields.Select(o => o.TypedName));
+                Assert.Equal(
+                    expectedClass.Functions.Select(o => (o.Function.Name, o.Visibility, o.Function.Code?.Span)),
+                    actualClass.Functions.Select(o => (o.Function.Name, o.Visibility, o.Function.Code?.Span)));
+            }
+            finally
+            {
+                Directory.Delete(dir, true);
+            }
+        }
+    }
+}
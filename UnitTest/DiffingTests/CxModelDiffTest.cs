@@ -0,0 +1,105 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Diffing;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.DiffingTests
+{
+    public class CxModelDiffTest
+    {
+        private const string Parameter = "LaunchActivatedEventArgs^ args) override";
+
+        private static CxHashNode Hash(string text, bool publicOnly = true)
+        {
+            var parsed = new CxParserWorker().Parse(new CxSourceText(text));
+            return new CxModelHasher { PublicOnly = publicOnly }.Hash(new CxModelAnalyzer().Visit(parsed.TranslationUnit));
+        }
+
+        [Fact]
+        public void TestWhitespaceChanges()
+        {
+            var text = File.ReadAllText("data/App.xaml.h");
+            var before = Hash(text);
+
+            Assert.Equal(before.Hash, Hash(text).Hash);
+
+            var after = Hash(text.Replace(Parameter, "LaunchActivatedEventArgs ^  args)  override"));
+            Assert.Equal(before.Hash, after.Hash);
+            Assert.Empty(CxModelDiff.Compare(before, after));
+        }
+
+        [Fact]
+        public void TestCommentChanges()
+        {
+            var text = File.ReadAllText("data/App.xaml.h");
+            var after = Hash(text.Replace("Activation::" + Parameter, "Activation:: /* launch */\n        " + Parameter));
+
+            Assert.Equal(Hash(text).Hash, after.Hash);
+        }
+
+        [Fact]
+        public void TestHashCache()
+        {
+            var dir = Path.Combine(Path.GetTempPath(), $"cppcx_hashes_{Guid.NewGuid():N}");
+            try
+            {
+                Func<CxSourceText, CxNamespace> analyze = source => new CxModelAnalyzer().Visit(new CxParserWorker().Parse(source).TranslationUnit);
+                var expected = new CxHashCache(directory: dir).GetOrHash("data/App.xaml.h", analyze);
+
+                var cache = new CxHashCache(directory: dir);
+                var actual = cache.GetOrHash("data/App.xaml.h", analyze);
+
+                Assert.Equal(1, cache.DiskHits);
+                Assert.Equal(0, cache.Misses);
+                Assert.Equal(expected.Hash, actual.Hash);
+                Assert.Empty(CxModelDiff.Compare(expected, actual));
+            }
+            finally
+            {
+                Directory.Delete(dir, true);
+            }
+        }
+
+        [Fact]
+        public void TestSignatureChange()
+        {
+            var text = File.ReadAllText("data/App.xaml.h");
+            var before = Hash(text);
+            var after = Hash(text.Replace(Parameter, "LaunchActivatedEventArgs^ args, int flags) override"));
+
+            var changes = CxModelDiff.Compare(before, after);
+            Assert.Equal(2, changes.Count);
+            Assert.Contains(changes, o => o.Kind == CxChangeKind.Removed && o.Before.Name == "OnLaunched");
+            Assert.Contains(changes, o => o.Kind == CxChangeKind.Added && o.After.Name == "OnLaunched");
+        }
+
+        [Fact]
+        public void TestPrivateChanges()
+        {
+            var text = File.ReadAllText("data/App.xaml.h");
+            var changed = text.Replace("static Windows::UI::Xaml::Controls::Frame^ CreateFrame();", "static Windows::UI::Xaml::Controls::Frame^ CreateFrame(int index);");
+            Assert.NotEqual(text, changed);
+
+            Assert.Empty(CxModelDiff.Compare(Hash(text), Hash(changed)));
+            Assert.Equal(2, CxModelDiff.Compare(Hash(text, false), Hash(changed, false)).Count);
+        }
+
+        [Fact]
+        public void TestPrivateChangesInSource()
+        {
+            var text = File.ReadAllText("data/App.xaml.cpp");
+            var changed = text.Replace("void App::RemoveWindowFromMap(int viewId)", "void App::RemoveWindowFromMap(int viewId, bool force)");
+            Assert.NotEqual(text, changed);
+
+            Assert.Empty(CxModelDiff.Compare(Hash(text), Hash(changed)));
+            Assert.Equal(2, CxModelDiff.Compare(Hash(text, false), Hash(changed, false)).Count);
+        }
+    }
+}
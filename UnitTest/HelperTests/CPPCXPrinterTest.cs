@@ -1,6 +1,9 @@
 using Antlr4.Runtime;
 using Antlr4.Runtime.Tree;
 using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
 using Xunit;
 using Xunit.Abstractions;
 using cppcx.Core.Helpers;
@@ -28,5 +31,50 @@ namespace UnitTest.HelperTests
             ParseTreeWalker.Default.Walk(writer, tu);
             _output.WriteLine(writer.Content);
         }
+
+        [Fact]
+        public void TestTruncatesText()
+        {
+            var tu = CxParser.Parse("data/App.xaml.cpp");
+
+            var output = new StringWriter();
+            new CPPCXPrinter(output) { MaxTextLength = 20 }.Print(tu);
+            var lines = output.ToString().Split(Environment.NewLine, StringSplitOptions.RemoveEmptyEntries);
+
+            Assert.StartsWith(" TranslationUnitContext using namespace", lines[0]);
+            Assert.EndsWith("...", lines[0]);
+            Assert.All(lines, o => Assert.True(o.TrimStart().Length < 100));
+        }
+
+        [Fact]
+        public void TestTruncatesTokensWithoutInput()
+        {
+            var token = new CommonToken(CPPCXLexer.Identifier, "abcdefghij");
+            var ctx = new ParserRuleContext { Start = token, Stop = token };
+            ctx.AddChild(new TerminalNodeImpl(token));
+
+            var output = new StringWriter();
+            new CPPCXPrinter(output) { MaxTextLength = 4 }.Print(ctx);
+
+            Assert.Equal(" ParserRuleContext abcd...", output.ToString().TrimEnd());
+        }
+
+        [Fact]
+        public void TestFilters()
+        {
+            var tu = CxParser.Parse("data/App.xaml.h");
+
+            var output = new StringWriter();
+            new CPPCXPrinter(output)
+            {
+                Text = CPPCXPrinterText.Tokens,
+                MaxDepth = 3,
+                Rules = new HashSet<int> { CPPCXParser.RULE_declaration },
+            }.Print(tu);
+            var lines = output.ToString().Split(Environment.NewLine, StringSplitOptions.RemoveEmptyEntries);
+
+            Assert.NotEmpty(lines);
+            Assert.All(lines, o => Assert.StartsWith("     DeclarationContext [", o));
+        }
     }
 }
@@ -0,0 +1,101 @@
+﻿using Antlr4.Runtime;
+using cppcx.Core.Incremental;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.IncrementalTests
+{
+    public class CxIncrementalDocumentTest
+    {
+        private static void AssertSameAsFullParse(CxIncrementalDocument document)
+        {
+            var parsed = new CxParserWorker().Parse(new CxSourceText(document.Text, document.Source.SourceName));
+            var tokens = (BufferedTokenStream)parsed.Tokens;
+            tokens.Fill();
+
+            Assert.Equal(parsed.TranslationUnit.ToStringTree(), document.TranslationUnit.ToStringTree());
+            Assert.Equal(
+                tokens.GetTokens().Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Line, o.Column, o.TokenIndex, o.Text)),
+                document.Tokens.Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Line, o.Column, o.TokenIndex, o.Text)));
+            Assert.Equal(parsed.SyntaxErrors, document.SyntaxErrors);
+
+            var expected = new cppcx.Core.Analyzers.TranslationUnitAnalyzer().Visit(parsed.TranslationUnit);
+            Assert.Equal(
+                expected.Bodies.Select(o => o.Body.ToString()),
+                document.Analysis.Bodies.Select(o => o.Body.ToString()));
+        }
+
+        [Fact]
+        public void TestEditInsideFunction()
+        {
+            var document = CxIncrementalDocument.FromFile("data/App.xaml.cpp");
+            var offset = document.Text.IndexOf("m_preLaunched = false;");
+
+            var res = document.Apply(new CxTextEdit(offset, "m_preLaunched = false;".Length, "m_preLaunched = true;\n    m_launched = IsLaunched(42);"));
+
+            Assert.True(res.IsIncremental);
+            Assert.Contains("m_launched", res.Declaration.GetText());
+            AssertSameAsFullParse(document);
+        }
+
+        [Fact]
+        public void TestEditInsideNamespace()
+        {
+            var document = CxIncrementalDocument.FromFile("data/App.xaml.cpp");
+            var offset = document.Text.IndexOf("(L\"AppMinWindowWidth\")");
+
+            var res = document.Apply(new CxTextEdit(offset, 0, "Renamed"));
+
+            Assert.True(res.IsIncremental);
+            AssertSameAsFullParse(document);
+            Assert.Contains(document.Analysis.Bodies.SelectMany(o => o.Body.GlobalVariables), o => o.Text.Contains("AppMinWindowWidthRenamed"));
+        }
+
+        [Fact]
+        public void TestEditShiftsSyntaxErrors()
+        {
+            var document = new CxIncrementalDocument("int a = 1;\nint b = 2 $;\nint c = 3 $;\n");
+            Assert.Equal(new[] { 2, 3 }, document.SyntaxErrors.Select(o => o.Line));
+
+            var res = document.Apply(new CxTextEdit(document.Text.IndexOf("1;"), 1, "1 +\n    1"));
+            Assert.True(res.IsIncremental);
+            Assert.Equal(new[] { 3, 4 }, document.SyntaxErrors.Select(o => o.Line));
+            AssertSameAsFullParse(document);
+
+            res = document.Apply(new CxTextEdit(document.Text.IndexOf(" $"), 2, " + 2"));
+            Assert.True(res.IsIncremental);
+            Assert.Equal(4, Assert.Single(document.SyntaxErrors).Line);
+            AssertSameAsFullParse(document);
+        }
+
+        [Fact]
+        public void TestEditBetweenDeclarationsParsesAll()
+        {
+            var document = CxIncrementalDocument.FromFile("data/App.xaml.cpp");
+            var offset = document.Text.IndexOf("void App::RemoveWindowFromMap");
+
+            var res = document.Apply(new CxTextEdit(offset, 0, "int g_windows = 0;\n\n"));
+
+            Assert.False(res.IsIncremental);
+            AssertSameAsFullParse(document);
+        }
+
+        [Fact]
+        public void TestEditThatSplitsDeclarationParsesAll()
+        {
+            var document = CxIncrementalDocument.FromFile("data/App.xaml.cpp");
+            var offset = document.Text.IndexOf("    SetupJumpList();");
+
+            var res = document.Apply(new CxTextEdit(offset, 0, "}\n\nvoid App::Split()\n{\n"));
+
+            Assert.False(res.IsIncremental);
+            AssertSameAsFullParse(document);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+﻿using cppcx.Core.Indexing;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.IndexingTests
+{
+    public class CxIdentifierIndexTest
+    {
+        private static CxIdentifierIndex Build(params string[] files)
+        {
+            var index = new CxIdentifierIndex();
+            foreach (var file in files)
+            {
+                index.Update(file);
+            }
+
+            return index;
+        }
+
+        [Fact]
+        public void TestFind()
+        {
+            var index = Build("data/App.xaml.h", "data/App.xaml.cpp");
+
+            Assert.Equal(2, index.FindFiles("ApplicationResourceKeys::AppMinWindowWidth").Count);
+            Assert.Equal(2, index.FindFiles("AddWindowToMap").Count);
+            var file = Assert.Single(index.FindFiles("CalculatorApp::App::AddWindowToMap"));
+            Assert.EndsWith("App.xaml.cpp", file);
+            Assert.Empty(index.FindFiles("ApplicationResourceKeys::NotAnIdentifier"));
+
+            var text = File.ReadAllText("data/App.xaml.h");
+            var occurrences = index.Find("OnLaunched").Where(o => o.Path.EndsWith("App.xaml.h")).ToList();
+            Assert.NotEmpty(occurrences);
+            Assert.All(occurrences, o => Assert.Equal("OnLaunched", text.Substring(o.Span.Start, o.Span.Length)));
+
+            var lines = File.ReadAllLines("data/App.xaml.h");
+            Assert.All(CxIdentifierIndex.Locate(occurrences), o => Assert.Equal("OnLaunched", lines[o.Line - 1].Substring(o.Column, o.Occurrence.Span.Length)));
+        }
+
+        [Fact]
+        public void TestUpdate()
+        {
+            var index = Build("data/App.xaml.h", "data/App.xaml.cpp");
+            var count = index.Find("App").Count;
+
+            index.Update("data/App.xaml.h", new CxSourceText("ref class App { void Renamed(); };"));
+            Assert.Single(index.FindFiles("Renamed"));
+            Assert.Empty(index.FindFiles("OnActivated").Where(o => o.EndsWith("App.xaml.h")));
+            Assert.True(index.Find("App").Count < count);
+
+            Assert.True(index.Remove("data/App.xaml.h"));
+            Assert.Empty(index.FindFiles("Renamed"));
+            Assert.Single(index.Files);
+        }
+
+        [Fact]
+        public void TestSaveLoad()
+        {
+            var index = Build("data/App.xaml.h", "data/App.xaml.cpp");
+            index.Remove("data/App.xaml.h");
+            index.Update("data/App.xaml.h");
+
+            using var stream = new MemoryStream();
+            index.Save(stream);
+            stream.Position = 0;
+            var loaded = CxIdentifierIndex.Load(stream);
+
+            Assert.Equal(index.Count, loaded.Count);
+            Assert.True(loaded.IsUpToDate("data/App.xaml.h"));
+            Assert.Equal(index.Find("App"), loaded.Find("App"));
+            Assert.Equal(index.FindFiles("ApplicationResourceKeys"), loaded.FindFiles("ApplicationResourceKeys"));
+
+            stream.SetLength(stream.Length / 2);
+            stream.Position = 0;
+            Assert.Throws<InvalidDataException>(() => CxIdentifierIndex.Load(stream));
+        }
+    }
+}
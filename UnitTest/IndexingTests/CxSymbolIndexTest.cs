@@ -0,0 +1,110 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Indexing;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.IndexingTests
+{
+    public class CxSymbolIndexTest
+    {
+        private static CxSymbolIndex Build(params string[] files)
+        {
+            var index = new CxSymbolIndex();
+            foreach (var file in files)
+            {
+                var source = CxSourceText.FromFile(file);
+                var parsed = new CxParserWorker().Parse(source);
+                index.Update(file, new CxModelAnalyzer().Visit(parsed.TranslationUnit), source);
+            }
+
+            return index;
+        }
+
+        [Theory]
+        [InlineData("data/App.xaml.h", "data/App.xaml.cpp")]
+        [InlineData("data/App.xaml.cpp", "data/App.xaml.h")]
+        public void TestLookup(string first, string second)
+        {
+            var index = Build(first, second);
+
+            var declaration = Assert.Single(index.GetDeclarations("Calculator::App::App::OnLaunched"));
+            Assert.EndsWith("App.xaml.h", declaration.Path);
+            Assert.Equal(38, declaration.Line);
+            Assert.Equal(CxSymbolKind.Class, index.GetKind(index.Find("Calculator::App::App")));
+
+            // `void App::OnLaunched(...)` in the global namespace of the .cpp.
+            var definition = Assert.Single(index.GetDefinitions("Calculator::App::App::OnLaunched"));
+            Assert.EndsWith("App.xaml.cpp", definition.Path);
+            Assert.Equal(194, definition.Line);
+            Assert.Equal(CxSymbolKind.Function, index.GetKind(index.Find("Calculator::App::App::OnLaunched")));
+
+            Assert.Equal(-1, index.Find("App::OnLaunched"));
+            Assert.Equal(-1, index.Find("App::Missing"));
+        }
+
+        [Fact]
+        public void TestResolvesEnclosingNamespace()
+        {
+            var source = new CxSourceText("namespace N { class C { void f(); }; }\nnamespace N { void C::f() { } }\n", "ns.cpp");
+            var index = new CxSymbolIndex();
+            index.Update(source.SourceName, new CxModelAnalyzer().Visit(new CxParserWorker().Parse(source).TranslationUnit), source);
+
+            var locations = index.GetLocations(index.Find("N::C::f"));
+            Assert.Equal(new[] { false, true }, locations.OrderBy(o => o.Line).Select(o => o.IsDefinition));
+        }
+
+        [Fact]
+        public void TestResolvesUsingWithComment()
+        {
+            var source = new CxSourceText("namespace N { class C { void f(); }; }\nusing /*x*/ namespace N;\nvoid C::f() { }\n", "using.cpp");
+            var index = new CxSymbolIndex();
+            index.Update(source.SourceName, new CxModelAnalyzer().Visit(new CxParserWorker().Parse(source).TranslationUnit), source);
+
+            var locations = index.GetLocations(index.Find("N::C::f"));
+            Assert.Equal(new[] { false, true }, locations.OrderBy(o => o.Line).Select(o => o.IsDefinition));
+        }
+
+        [Fact]
+        public void TestUpdateAndRemove()
+        {
+            var index = Build("data/App.xaml.h", "data/App.xaml.cpp");
+            var id = index.Find("Calculator::App::App::OnLaunched");
+            Assert.Equal(2, index.GetLocations(id).Count);
+
+            index.Update("data/App.xaml.cpp", new CxNamespace());
+            Assert.Single(index.GetLocations(id));
+            Assert.Empty(index.GetDefinitions("Calculator::App::App::OnLaunched"));
+
+            Assert.True(index.Remove("data/App.xaml.h"));
+            Assert.Empty(index.GetDeclarations("Calculator::App::App::OnLaunched"));
+            Assert.Equal(id, index.Find("Calculator::App::App::OnLaunched"));
+        }
+
+        [Fact]
+        public void TestSaveAndLoad()
+        {
+            var index = Build("data/App.xaml.h", "data/App.xaml.cpp");
+            var stream = new MemoryStream();
+            index.Save(stream);
+
+            stream.Position = 0;
+            var loaded = CxSymbolIndex.Load(stream);
+
+            Assert.Equal(index.Count, loaded.Count);
+            Assert.Equal(index.Files.OrderBy(o => o), loaded.Files.OrderBy(o => o));
+            for (int id = 0; id < index.Count; ++id)
+            {
+                Assert.Equal(index.GetQualifiedName(id), loaded.GetQualifiedName(id));
+                Assert.Equal(index.GetLocations(id).OrderBy(o => o.Span.Start), loaded.GetLocations(id).OrderBy(o => o.Span.Start));
+            }
+            Assert.True(loaded.IsUpToDate("data/App.xaml.h"));
+        }
+    }
+}
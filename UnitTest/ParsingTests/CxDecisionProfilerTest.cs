@@ -0,0 +1,41 @@
+﻿using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    public class CxDecisionProfilerTest
+    {
+        [Fact]
+        public void Test()
+        {
+            var profiler = new CxDecisionProfiler();
+            var profiled = profiler.ParseFile("data/App.xaml.h");
+            profiler.ParseFile("data/App.xaml.cpp");
+
+            var expected = new CxParserWorker(new CxParseOptions { PredictionStrategy = CxPredictionStrategy.LL }).ParseFile("data/App.xaml.h");
+            Assert.Equal(expected.TranslationUnit.ToStringTree(), profiled.TranslationUnit.ToStringTree());
+
+            var decisions = profiler.GetDecisions();
+            Assert.NotEmpty(decisions);
+            Assert.All(decisions, o => Assert.True(o.Invocations > 0));
+            Assert.Contains(decisions, o => o.Rule == "declSpecifierSeq");
+            Assert.Equal(decisions.OrderByDescending(o => o.TimeMs).Select(o => o.TimeMs), decisions.Select(o => o.TimeMs));
+            Assert.Equal(decisions.Sum(o => o.Invocations), profiler.GetRules().Sum(o => o.Invocations));
+
+            var csv = new StringWriter();
+            CxDecisionProfiler.WriteCsv(csv, decisions);
+            Assert.Equal(decisions.Count + 1, csv.ToString().Split('\n', StringSplitOptions.RemoveEmptyEntries).Length);
+
+            var json = new MemoryStream();
+            CxDecisionProfiler.WriteJson(json, decisions);
+            Assert.Equal(decisions.Count, JsonDocument.Parse(json.ToArray()).RootElement.GetArrayLength());
+        }
+    }
+}
@@ -0,0 +1,38 @@
+﻿using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using UnitTest.Utils;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    [Collection(DfaCacheCollection.Name)]
+    public class CxDfaSnapshotTest
+    {
+        [Fact]
+        public void TestSaveAndLoad()
+        {
+            var pool = new CxParserPool();
+            var expected = pool.ParseFile("data/App.xaml.cpp").TranslationUnit.ToStringTree();
+
+            var snapshot = new MemoryStream();
+            CxDfaSnapshot.Save(snapshot);
+            pool.ClearDfaCache();
+
+            snapshot.Position = 0;
+            Assert.True(CxDfaSnapshot.Load(snapshot) > 0);
+            Assert.Equal(expected, pool.ParseFile("data/App.xaml.cpp").TranslationUnit.ToStringTree());
+        }
+
+        [Fact]
+        public void TestRejectsOtherData()
+        {
+            var stream = new MemoryStream(Encoding.UTF8.GetBytes("not a snapshot"));
+            Assert.Throws<InvalidDataException>(() => CxDfaSnapshot.Load(stream));
+        }
+    }
+}
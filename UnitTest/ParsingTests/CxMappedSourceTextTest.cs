@@ -0,0 +1,65 @@
+﻿using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    public class CxMappedSourceTextTest
+    {
+        private static void AssertSameTokens(string filename)
+        {
+            var expected = new CPPCXLexer(CxSourceText.FromFile(filename)).GetAllTokens();
+
+            using var mapped = CxMappedSourceText.Open(filename);
+            var actual = new CPPCXLexer(mapped).GetAllTokens();
+
+            Assert.Equal(CxSourceText.FromFile(filename).Size, mapped.Size);
+            Assert.Equal(expected.Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Line, o.Column, o.Text)), actual.Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Line, o.Column, o.Text)));
+            Assert.Equal(File.ReadAllText(filename), mapped.ToString());
+        }
+
+        [Theory]
+        [InlineData("data/App.xaml.h")]
+        [InlineData("data/App.xaml.cpp")]
+        public void TestAscii(string filename)
+        {
+            AssertSameTokens(filename);
+
+            using var mapped = CxMappedSourceText.Open(filename);
+            Assert.Equal(0, mapped.DecodedChars);
+        }
+
+        [Theory]
+        [InlineData("utf-8")]
+        [InlineData("utf-16")]
+        public void TestNonAscii(string encoding)
+        {
+            var filename = Path.GetTempFileName();
+            try
+            {
+                var sb = new StringBuilder();
+                for (int i = 0; i < 5000; ++i)
+                {
+                    sb.AppendLine($"int value{i} = {i}; // padding so that the file spans several blocks");
+                    if (i % 1000 == 0) sb.AppendLine($"auto s{i} = L\"Größe – 大小 😀 {i}\";");
+                }
+                File.WriteAllText(filename, sb.ToString(), Encoding.GetEncoding(encoding));
+
+                AssertSameTokens(filename);
+
+                using var mapped = CxMappedSourceText.Open(filename);
+                Assert.True(mapped.DecodedChars > 0);
+                if (encoding == "utf-8") Assert.True(mapped.DecodedChars < mapped.Size);
+            }
+            finally
+            {
+                File.Delete(filename);
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using UnitTest.Utils;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    [Collection(DfaCacheCollection.Name)]
+    public class CxParserPoolTest
+    {
+        // Runs a callback while the lexer reads its first char, i.e. from inside a parse.
+        private class CallbackStream : ICharStream
+        {
+            private readonly ICharStream _inner;
+            private Action _callback;
+
+            public CallbackStream(ICharStream inner, Action callback)
+            {
+                _inner = inner;
+                _callback = callback;
+            }
+
+            public int Index => _inner.Index;
+            public int Size => _inner.Size;
+            public string SourceName => _inner.SourceName;
+
+            public int LA(int i)
+            {
+                var callback = _callback;
+                _callback = null;
+                callback?.Invoke();
+                return _inner.LA(i);
+            }
+
+            public void Consume() => _inner.Consume();
+            public int Mark() => _inner.Mark();
+            public void Release(int marker) => _inner.Release(marker);
+            public void Seek(int index) => _inner.Seek(index);
+            public string GetText(Interval interval) => _inner.GetText(interval);
+        }
+
+        [Fact]
+        public void TestReusesWorkers()
+        {
+            var pool = new CxParserPool();
+            var expected = new CxParserWorker().ParseFile("data/App.xaml.cpp").TranslationUnit.ToStringTree();
+
+            var trees = new List<string>();
+            Parallel.For(0, 16, new ParallelOptions { MaxDegreeOfParallelism = 4 }, _ =>
+            {
+                var tree = pool.ParseFile("data/App.xaml.cpp").TranslationUnit.ToStringTree();
+                lock (trees) trees.Add(tree);
+            });
+
+            Assert.Equal(16, pool.Parses);
+            Assert.InRange(pool.Workers, 1, 4);
+            Assert.InRange(pool.StableDfaParses, 0, pool.Parses);
+            Assert.All(trees, o => Assert.Equal(expected, o));
+        }
+
+        [Fact]
+        public void TestClearDfaCache()
+        {
+            var pool = new CxParserPool { MaxDfaStates = 1 };
+            var expected = pool.ParseFile("data/App.xaml.h").TranslationUnit.ToStringTree();
+
+            Assert.Equal(1, pool.Clears);
+            Assert.Equal(expected, pool.ParseFile("data/App.xaml.h").TranslationUnit.ToStringTree());
+            Assert.Equal(2, pool.Clears);
+        }
+
+        [Fact]
+        public void TestClearDfaCacheInsideParse()
+        {
+            var pool = new CxParserPool();
+            pool.ParseFile("data/App.xaml.h");
+            Assert.True(CxParserPool.DfaStates > 0);
+
+            var snapshot = Path.Combine(Path.GetTempPath(), $"cppcx_dfa_{Guid.NewGuid():N}.bin");
+            Exception thrown = null;
+            var stream = new CallbackStream(CxSourceText.FromFile("data/App.xaml.h"), () =>
+            {
+                pool.ClearDfaCache();
+                thrown = Record.Exception(() => pool.SaveDfaSnapshot(snapshot));
+            });
+            try
+            {
+                new CxParserWorker().Parse(stream);
+            }
+            finally
+            {
+                File.Delete(snapshot);
+            }
+
+            Assert.IsType<InvalidOperationException>(thrown);
+            Assert.Equal(0, CxParserPool.DfaStates);
+            Assert.Equal(1, pool.Clears);
+        }
+    }
+}
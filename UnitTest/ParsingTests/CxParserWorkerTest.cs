@@ -0,0 +1,99 @@
+﻿using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    public class CxParserWorkerTest
+    {
+        [Theory]
+        [InlineData("data/App.xaml.h")]
+        [InlineData("data/App.xaml.cpp")]
+        public void TestTwoStageProducesSameTree(string filename)
+        {
+            var ll = new CxParserWorker(new CxParseOptions { PredictionStrategy = CxPredictionStrategy.LL }).ParseFile(filename);
+            var twoStageWorker = new CxParserWorker(new CxParseOptions { PredictionStrategy = CxPredictionStrategy.TwoStage });
+            var twoStage = twoStageWorker.ParseFile(filename);
+
+            Assert.Equal(ll.TranslationUnit.ToStringTree(), twoStage.TranslationUnit.ToStringTree());
+            Assert.Equal(ll.SyntaxErrors.Count, twoStage.SyntaxErrors.Count);
+            Assert.Equal(1, twoStageWorker.Statistics.SllParses);
+            Assert.Equal(twoStage.UsedLlFallback ? 1 : 0, twoStageWorker.Statistics.LlFallbacks);
+        }
+
+        [Fact]
+        public void TestTwoStageFallbackReportsErrorsOnce()
+        {
+            var source = "int a;\nclass C { void f() { } ) };\nint b = 1 $;\n";
+            var ll = new CxParserWorker(new CxParseOptions { PredictionStrategy = CxPredictionStrategy.LL }).Parse(new CxSourceText(source));
+            var twoStage = new CxParserWorker(new CxParseOptions { PredictionStrategy = CxPredictionStrategy.TwoStage }).Parse(new CxSourceText(source));
+
+            Assert.True(twoStage.UsedLlFallback);
+            Assert.Equal(ll.SyntaxErrors, twoStage.SyntaxErrors);
+            Assert.Contains(twoStage.SyntaxErrors, o => o.Line == 3);
+        }
+
+        [Fact]
+        public void TestWorkerIsReusable()
+        {
+            var worker = new CxParserWorker();
+            var first = worker.ParseFile("data/App.xaml.h");
+            worker.ParseFile("data/App.xaml.cpp");
+            var again = worker.ParseFile("data/App.xaml.h");
+
+            Assert.Equal(first.TranslationUnit.ToStringTree(), again.TranslationUnit.ToStringTree());
+            Assert.Equal(3, worker.Statistics.Parses);
+        }
+
+        [Theory]
+        [InlineData("data/App.xaml.h")]
+        [InlineData("data/App.xaml.cpp")]
+        public void TestDeclarationRecoveryProducesSameTree(string filename)
+        {
+            var expected = new CxParserWorker().ParseFile(filename);
+            var res = new CxParserWorker(new CxParseOptions { ErrorRecovery = CxErrorRecovery.Declaration }).ParseFile(filename);
+
+            Assert.Equal(expected.TranslationUnit.ToStringTree(), res.TranslationUnit.ToStringTree());
+            Assert.Empty(res.SkippedRegions);
+        }
+
+        [Fact]
+        public void TestDeclarationRecoverySkipsBrokenDeclaration()
+        {
+            var source = "int a;\nclass C { void f() { } ) };\nint b;\n";
+            var res = new CxParserWorker(new CxParseOptions { ErrorRecovery = CxErrorRecovery.Declaration }).Parse(new CxSourceText(source));
+
+            var region = Assert.Single(res.SkippedRegions);
+            Assert.Equal(CxSkipReason.SyntaxError, region.Reason);
+            Assert.Equal("class C { void f() { } ) };", source.Substring(region.Span.Start, region.Span.Length));
+            Assert.Equal(2, region.Line);
+            Assert.Equal(2, res.TranslationUnit.declarationseq().declaration().Length);
+            Assert.Single(res.SyntaxErrors);
+        }
+
+        [Fact]
+        public void TestDeclarationRecoveryKeepsLexerErrors()
+        {
+            var source = "int a;\nclass C { void f() { int x = 1 $; } ) };\nint b;\n";
+            var res = new CxParserWorker(new CxParseOptions { ErrorRecovery = CxErrorRecovery.Declaration }).Parse(new CxSourceText(source));
+
+            Assert.Single(res.SkippedRegions);
+            Assert.Equal(2, res.SyntaxErrors.Count);
+            Assert.Contains(res.SyntaxErrors, o => o.Message.Contains("'$'"));
+        }
+
+        [Fact]
+        public void TestTokenBudget()
+        {
+            var res = new CxParserWorker(new CxParseOptions { TokenBudget = 50 }).ParseFile("data/App.xaml.cpp");
+
+            Assert.True(res.BudgetExceeded);
+            Assert.Equal(CxSkipReason.TokenBudget, res.SkippedRegions.Last().Reason);
+            Assert.Equal(res.Tokens.TokenSource.InputStream.Size, res.SkippedRegions.Last().Span.End);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+﻿using Antlr4.Runtime;
+using cppcx.Core.Analyzers;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using UnitTest.Utils;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    public class CxSourceTextTest
+    {
+        [Theory]
+        [InlineData("data/App.xaml.h")]
+        [InlineData("data/App.xaml.cpp")]
+        public void TestSameTokensAsAntlrInputStream(string filename)
+        {
+            var expected = new CPPCXLexer(new AntlrInputStream(File.ReadAllText(filename))).GetAllTokens();
+            var actual = new CPPCXLexer(CxSourceText.FromFile(filename)).GetAllTokens();
+
+            Assert.Equal(expected.Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Text)), actual.Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Text)));
+        }
+
+        [Fact]
+        public void TestSourceText()
+        {
+            var tu = CxParser.Parse("data/App.xaml.h");
+            // int a, b = 3;
+            var decl = tu.declarationseq().declaration()[0].namespaceDefinition().declarationseq().declaration()[0].namespaceDefinition().declarationseq().declaration()[2].blockDeclaration().simpleDeclaration();
+
+            Assert.Equal("int a, b = 3;", decl.GetSourceText());
+            Assert.Equal("inta,b=3;", decl.GetText());
+            Assert.Equal(decl.GetSourceText().Length, CxSourceSpan.Of(decl).Length);
+        }
+
+        [Fact]
+        public void TestCodeTextDropsComments()
+        {
+            var source = "int a, /* b */\n    b = 3; // c\nint g = 1 + /* two */\n    2;\n";
+            var tu = new CxParserWorker().Parse(new CxSourceText(source)).TranslationUnit;
+            var decl = tu.declarationseq().declaration()[0].blockDeclaration().simpleDeclaration();
+
+            Assert.Equal("int a, b = 3;", decl.GetCodeText());
+            Assert.Equal("1 + 2", new CxModelAnalyzer().Visit(tu).GlobalVariables.Single(o => o.TypedName.Name == "g").InitValue);
+        }
+
+        [Theory]
+        [InlineData("auto g = R\"(a\"b)\" /* c */;", "R\"(a\"b)\"")]
+        [InlineData("int g = 1 + // c \\\n    2;", "1 + 2")]
+        [InlineData("int g = 1 # x\n    + 2;", "1 + 2")]
+        [InlineData("int g = 1+2;", "1+2")]
+        public void TestCodeTextFollowsLexer(string source, string expected)
+        {
+            var tu = new CxParserWorker().Parse(new CxSourceText(source)).TranslationUnit;
+
+            Assert.Equal(expected, new CxModelAnalyzer().Visit(tu).GlobalVariables.Single(o => o.TypedName.Name == "g").InitValue);
+        }
+
+        [Fact]
+        public void TestNameTable()
+        {
+            var names = new NameTable();
+            var source = "App::App App";
+
+            var first = names.Get(source.AsSpan(0, 3));
+            var second = names.Get(source.AsSpan(5, 3));
+            var third = names.Get(source.AsSpan(9, 3));
+
+            Assert.Equal("App", first);
+            Assert.Same(first, second);
+            Assert.Same(first, third);
+            Assert.Equal(1, names.Count);
+
+            for (int i = 0; i < 1000; ++i)
+            {
+                names.Get($"name{i}".AsSpan());
+            }
+            Assert.Equal(1001, names.Count);
+            Assert.Same(first, names.Get("App".AsSpan()));
+        }
+    }
+}
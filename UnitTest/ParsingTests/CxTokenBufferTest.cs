@@ -0,0 +1,72 @@
+﻿using Antlr4.Runtime;
+using cppcx.Core.Analyzers;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    public class CxTokenBufferTest
+    {
+        [Theory]
+        [InlineData("data/App.xaml.h")]
+        [InlineData("data/App.xaml.cpp")]
+        public void TestSameTokensAsCommonTokenStream(string filename)
+        {
+            var all = new CPPCXLexer(CxSourceText.FromFile(filename)).GetAllTokens();
+            var expected = all.Where(o => o.Channel == TokenConstants.DefaultChannel).ToList();
+            var hidden = all.Where(o => o.Channel != TokenConstants.DefaultChannel).ToList();
+
+            var buffer = CxTokenBuffer.Lex(new CPPCXLexer(null), CxSourceText.FromFile(filename));
+
+            Assert.Equal(expected.Count + 1, buffer.Size);
+            Assert.Equal(TokenConstants.EOF, buffer.Get(buffer.Size - 1).Type);
+            Assert.Equal(
+                expected.Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Line, o.Column, o.Text)),
+                Enumerable.Range(0, expected.Count).Select(buffer.Get).Select(o => (o.Type, o.StartIndex, o.StopIndex, o.Line, o.Column, o.Text)));
+            Assert.Equal(hidden.Select(o => (o.Type, o.StartIndex, o.Line)), buffer.HiddenTokens.Select(o => (o.Type, o.StartIndex, o.Line)));
+            Assert.Same(buffer.Get(3), buffer.Get(3));
+
+            buffer.DropHiddenTokens();
+            Assert.Null(buffer.HiddenTokens);
+        }
+
+        [Fact]
+        public void TestHiddenTokensBefore()
+        {
+            var buffer = CxTokenBuffer.Lex(new CPPCXLexer(null), new CxSourceText("#a\n#b\nint x;\n#c\nint y;\n#d\n", "hidden.cpp"));
+
+            Assert.Equal(new[] { 0, 3 }, buffer.GetHiddenTokensBefore(0).Select(o => o.StartIndex));
+            Assert.Empty(buffer.GetHiddenTokensBefore(1));
+            Assert.Equal(new[] { 13 }, buffer.GetHiddenTokensBefore(3).Select(o => o.StartIndex));
+            Assert.Equal(new[] { 23 }, buffer.GetHiddenTokensBefore(buffer.Size - 1).Select(o => o.StartIndex));
+        }
+
+        [Theory]
+        [InlineData("data/App.xaml.h")]
+        [InlineData("data/App.xaml.cpp")]
+        public void TestParse(string filename)
+        {
+            var expected = new CxParserWorker().ParseFile(filename);
+            var actual = new CxParserWorker(new CxParseOptions { CompactTokens = true }).ParseFile(filename);
+
+            Assert.IsType<CxTokenBuffer>(actual.Tokens);
+            Assert.Equal(expected.TranslationUnit.ToStringTree(), actual.TranslationUnit.ToStringTree());
+            Assert.Equal(expected.SyntaxErrors.Count, actual.SyntaxErrors.Count);
+
+            var expectedModel = new CxModelAnalyzer().Visit(expected.TranslationUnit);
+            var actualModel = new CxModelAnalyzer().Visit(actual.TranslationUnit);
+            Assert.Equal(expectedModel.Functions.Select(o => (o.Name, o.Code?.Span)), actualModel.Functions.Select(o => (o.Name, o.Code?.Span)));
+        }
+
+        [Fact]
+        public void TestRejectedWithSkippedBodies()
+        {
+            Assert.Throws<ArgumentException>(() => new CxParserWorker(new CxParseOptions { CompactTokens = true, SkipFunctionBodies = true }));
+        }
+    }
+}
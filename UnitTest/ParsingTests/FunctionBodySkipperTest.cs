@@ -0,0 +1,42 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.ParsingTests
+{
+    public class FunctionBodySkipperTest
+    {
+        [Fact]
+        public void TestDeclarationsOnlyParse()
+        {
+            var full = new CxParserWorker().ParseFile("data/App.xaml.cpp");
+            var declOnly = new CxParserWorker(new CxParseOptions { SkipFunctionBodies = true }).ParseFile("data/App.xaml.cpp");
+
+            Assert.NotEmpty(declOnly.SkippedBodies);
+            Assert.Empty(full.SkippedBodies);
+
+            var fullDefs = new NamespaceBodyAnalyzer().Visit(full.TranslationUnit.declarationseq()).FunctionDefinitions;
+            var declOnlyDefs = new NamespaceBodyAnalyzer().Visit(declOnly.TranslationUnit.declarationseq()).FunctionDefinitions;
+            Assert.Equal(fullDefs.Count, declOnlyDefs.Count);
+
+            var fullAnalyzer = new FunctionDefinitionAnalyzer();
+            var lazyAnalyzer = new FunctionDefinitionAnalyzer(declOnly.SkippedBodies);
+            for (int i = 0; i < fullDefs.Count; ++i)
+            {
+                var expected = fullAnalyzer.Visit(fullDefs[i].Context);
+                var actual = lazyAnalyzer.Visit(declOnlyDefs[i].Context);
+
+                Assert.Equal(expected.ClassName, actual.ClassName);
+                Assert.Equal(expected.Name, actual.Name);
+                Assert.False(actual.IsStatementsLoaded);
+                Assert.Equal(expected.Statements?.GetText(), actual.Statements?.GetText());
+                Assert.True(actual.IsStatementsLoaded);
+            }
+        }
+    }
+}
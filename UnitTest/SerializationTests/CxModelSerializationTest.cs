@@ -0,0 +1,104 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Models;
+using cppcx.Core.Serialization;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+using System.Threading.Tasks;
+using UnitTest.Utils;
+using Xunit;
+
+namespace UnitTest.SerializationTests
+{
+    public class CxModelSerializationTest
+    {
+        private static CxNamespace Analyze(string filename)
+        {
+            return new CxModelAnalyzer { Detached = true }.Visit(CxParser.Parse(filename));
+        }
+
+        [Fact]
+        public void TestRoundTrip()
+        {
+            var files = new[] { "data/App.xaml.h", "data/App.xaml.cpp" };
+            var models = files.Select(Analyze).ToList();
+
+            var stream = new MemoryStream();
+            using (var writer = new CxModelWriter(stream, leaveOpen: true))
+            {
+                for (int i = 0; i < files.Length; ++i)
+                {
+                    writer.Add(files[i], models[i]);
+                }
+            }
+
+            using var reader = CxModelReader.FromBytes(stream.ToArray());
+            Assert.Equal(files, reader.Names);
+            for (int i = 0; i < files.Length; ++i)
+            {
+                Assert.Equal(JsonSerializer.Serialize(models[i]), JsonSerializer.Serialize(reader.Read(i)));
+            }
+            Assert.Null(reader.Read("data/missing.h"));
+        }
+
+        [Fact]
+        public void TestMappedFile()
+        {
+            var model = Analyze("data/App.xaml.h");
+            var path = Path.GetTempFileName();
+            try
+            {
+                using (var writer = CxModelWriter.Create(path))
+                {
+                    writer.Add("App.xaml.h", model);
+                }
+
+                var reader = CxModelReader.Open(path);
+                Assert.Equal(JsonSerializer.Serialize(model), JsonSerializer.Serialize(reader.Read("App.xaml.h")));
+                var names = reader.Names;
+                reader.Dispose();
+
+                Assert.Equal(new[] { "App.xaml.h" }, names);
+                Assert.Throws<ObjectDisposedException>(() => reader.Names);
+                Assert.Throws<ObjectDisposedException>(() => reader.GetName(0));
+                Assert.Throws<ObjectDisposedException>(() => reader.Read("App.xaml.h"));
+            }
+            finally
+            {
+                File.Delete(path);
+            }
+        }
+
+        [Fact]
+        public void TestRejectsOtherData()
+        {
+            Assert.Throws<InvalidDataException>(() => CxModelReader.FromBytes(Encoding.UTF8.GetBytes("{ \"Namespace\": \"\" }")));
+        }
+
+        [Theory]
+        [InlineData(0)]
+        [InlineData(0x7F)]
+        public void TestRejectsInvalidChildOffset(byte distance)
+        {
+            var root = new CxNamespace();
+            root.NestedNamespaces.Add(new CxNamespace { Namespace = "A" });
+
+            var stream = new MemoryStream();
+            using (var writer = new CxModelWriter(stream, leaveOpen: true))
+            {
+                writer.Add("root", root);
+            }
+
+            // Header, then `A` in 6 bytes, then the root: name, child count and the distance back to `A`.
+            var data = stream.ToArray();
+            Assert.Equal(6, data[16]);
+            data[16] = distance;
+
+            using var reader = CxModelReader.FromBytes(data);
+            Assert.Throws<InvalidDataException>(() => reader.Read(0));
+        }
+    }
+}
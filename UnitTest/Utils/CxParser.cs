@@ -1,4 +1,5 @@
 ﻿using Antlr4.Runtime;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Linq;
@@ -9,14 +10,11 @@ namespace UnitTest.Utils
 {
     public static class CxParser
     {
+        private static readonly CxParserPool Pool = new CxParserPool();
+
         public static CPPCXParser.TranslationUnitContext Parse(string filename)
         {
-            var stream = CharStreams.fromPath(filename);
-            var lexer = new CPPCXLexer(stream);
-            var tokens = new CommonTokenStream(lexer);
-            var parser = new CPPCXParser(tokens);
-            parser.BuildParseTree = true;
-            return parser.translationUnit();
+            return Pool.ParseFile(filename).TranslationUnit;
         }
     }
 }
@@ -0,0 +1,16 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace UnitTest.Utils
+{
+    // Tests that clear or replace the process-wide DFA cache, and so can't run alongside others.
+    [CollectionDefinition(Name, DisableParallelization = true)]
+    public class DfaCacheCollection
+    {
+        public const string Name = "DFA cache";
+    }
+}
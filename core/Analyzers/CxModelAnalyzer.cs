@@ -0,0 +1,362 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using cppcx.Core.Helpers;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Analyzers
+{
+    // Builds the whole Cx model of a translation unit in a single walk over its declarations.
+    public class CxModelAnalyzer : CPPCXParserBaseListener
+    {
+        private class ClassFrame
+        {
+            public CxClass Class;
+            public CxVisibility Visibility;
+        }
+
+        private readonly NameTable _names;
+        private readonly GlobalVariableAnalyzer _globalVariableAnalyzer;
+        private readonly FunctionDeclarationAnalyzer _functionDeclarationAnalyzer;
+        private readonly FunctionDefinitionAnalyzer _functionDefinitionAnalyzer;
+        private readonly ParameterAnalyzer _parameterAnalyzer;
+        private readonly Stack<CxNamespace> _namespaces = new Stack<CxNamespace>();
+        private readonly Stack<ClassFrame> _classes = new Stack<ClassFrame>();
+        private readonly Dictionary<CxNamespace, Dictionary<string, CxNamespace>> _nestedNamespaces = new Dictionary<CxNamespace, Dictionary<string, CxNamespace>>();
+        private int _sourceLength = -1;
+        private string _sourceHash;
+
+        // Detached models keep only source spans of code blocks, so the parse tree, tokens and
+        // source text can be collected once the model is built.
+        public bool Detached { get; init; } = false;
+
+        public CxModelAnalyzer(IReadOnlyDictionary<int, SkippedFunctionBody> skippedBodies = null, NameTable names = null)
+        {
+            _names = names ?? new NameTable();
+            _globalVariableAnalyzer = new GlobalVariableAnalyzer(_names);
+            _functionDeclarationAnalyzer = new FunctionDeclarationAnalyzer(_names);
+            _functionDefinitionAnalyzer = new FunctionDefinitionAnalyzer(skippedBodies, _names);
+            _parameterAnalyzer = new ParameterAnalyzer(_names);
+        }
+
+        public CxNamespace Visit([NotNull] CPPCXParser.TranslationUnitContext context)
+        {
+            var root = new CxNamespace();
+
+            _namespaces.Clear();
+            _classes.Clear();
+            _nestedNamespaces.Clear();
+            _namespaces.Push(root);
+            (_sourceLength, _sourceHash) = Detached ? GetSourceStamp(context.Start.InputStream) : (-1, null);
+
+            DeclarationTreeWalker.Default.Walk(this, context);
+
+            _nestedNamespaces.Clear();
+            return root;
+        }
+
+        public override void EnterNamespaceDefinition([NotNull] CPPCXParser.NamespaceDefinitionContext context)
+        {
+            var current = _namespaces.Peek();
+
+            var qualifiedNs = context.qualifiednamespacespecifier();
+            if (qualifiedNs != null)
+            {
+                var nestedNames = qualifiedNs.nestedNameSpecifier();
+                if (nestedNames != null)
+                {
+                    foreach (var part in _names.GetQualifiedNameParts(nestedNames, new List<string>()))
+                    {
+                        current = GetOrAddNamespace(current, part);
+                    }
+                }
+
+                current = GetOrAddNamespace(current, _names.Get(qualifiedNs.namespaceName()));
+            }
+
+            _namespaces.Push(current);
+        }
+
+        public override void ExitNamespaceDefinition([NotNull] CPPCXParser.NamespaceDefinitionContext context)
+        {
+            _namespaces.Pop();
+        }
+
+        public override void EnterUsingDirective([NotNull] CPPCXParser.UsingDirectiveContext context)
+        {
+            var parts = new List<string>();
+            if (context.nestedNameSpecifier() != null) _names.GetQualifiedNameParts(context.nestedNameSpecifier(), parts);
+            parts.Add(_names.Get(context.namespaceName()));
+
+            _namespaces.Peek().UsingNamespaces.Add(string.Join("::", parts));
+        }
+
+        public override void EnterClassSpecifier([NotNull] CPPCXParser.ClassSpecifierContext context)
+        {
+            var head = context.classHead();
+            var virtSpecifier = head.classVirtSpecifier();
+
+            var cls = new CxClass
+            {
+                Name = _names.Get(head.classHeadName()) ?? string.Empty,
+                IsSealed = virtSpecifier?.Sealed() != null,
+                IsFinal = virtSpecifier?.Final() != null,
+                Span = CxSourceSpan.Of(context),
+            };
+
+            if (_classes.Count > 0)
+            {
+                _classes.Peek().Class.NestedClasses.Add(cls);
+            }
+            else
+            {
+                _namespaces.Peek().Classes.Add(cls);
+            }
+
+            _classes.Push(new ClassFrame
+            {
+                Class = cls,
+                Visibility = head.classKey()?.Class() != null ? CxVisibility.Private : CxVisibility.Public,
+            });
+        }
+
+        public override void ExitClassSpecifier([NotNull] CPPCXParser.ClassSpecifierContext context)
+        {
+            _classes.Pop();
+        }
+
+        public override void EnterAccessSpecifier([NotNull] CPPCXParser.AccessSpecifierContext context)
+        {
+            if (_classes.Count == 0 || context.Parent is not CPPCXParser.MemberSpecificationContext) return;
+
+            _classes.Peek().Visibility = ToVisibility(context);
+        }
+
+        public override void EnterSimpleDeclaration([NotNull] CPPCXParser.SimpleDeclarationContext context)
+        {
+            if (_classes.Count > 0) return;
+
+            var ns = _namespaces.Peek();
+            switch (NamespaceBodyAnalyzer.IsVariableDeclaration(context))
+            {
+                case NamespaceBodyAnalyzer.DeclarationType.Variable:
+                    foreach (var variable in _globalVariableAnalyzer.Visit(context))
+                    {
+                        ns.GlobalVariables.Add(new CxGlobalVariable
+                        {
+                            TypedName = new CxTypedName(new CxType(variable.Type), variable.Name),
+                            InitValue = GetInitValue(variable.InitContext),
+                            IsExtern = variable.IsExtern,
+                            Span = CxSourceSpan.Of(context),
+                        });
+                    }
+                    break;
+                case NamespaceBodyAnalyzer.DeclarationType.Function:
+                    var function = _functionDeclarationAnalyzer.Visit(context);
+                    ns.Functions.Add(new CxFunction
+                    {
+                        Name = function.Name,
+                        ReturnType = new CxType(function.ReturnType),
+                        Parameters = ToCxParameters(function.Parameters),
+                        IsStatic = IsStatic(context.declSpecifierSeq()?.declSpecifier()),
+                        Span = CxSourceSpan.Of(context),
+                    });
+                    break;
+            }
+        }
+
+        public override void EnterFunctionDefinition([NotNull] CPPCXParser.FunctionDefinitionContext context)
+        {
+            if (context.Parent is CPPCXParser.PropertyBodyContext) return;
+
+            var definition = _functionDefinitionAnalyzer.Visit(context);
+            var declSpecs = context.declSpecifierSeq()?.declSpecifier();
+
+            var function = new CxFunction
+            {
+                Name = definition.ClassName == null || _classes.Count > 0 ? definition.Name : $"{definition.ClassName}::{definition.Name}",
+                ReturnType = definition.ReturnType == null ? null : new CxType(definition.ReturnType),
+                Parameters = ToCxParameters(definition.Parameters),
+                IsStatic = IsStatic(declSpecs),
+                Code = CreateCode(context.functionBody()),
+                Span = CxSourceSpan.Of(context),
+            };
+
+            if (_classes.Count > 0)
+            {
+                var frame = _classes.Peek();
+                frame.Class.Functions.Add(new CxMemberFunction
+                {
+                    Function = function,
+                    Visibility = frame.Visibility,
+                    IsVirtual = IsVirtual(declSpecs),
+                    IsOverriden = IsOverriden(context.virtualSpecifierSeq()),
+                });
+            }
+            else
+            {
+                _namespaces.Peek().Functions.Add(function);
+            }
+        }
+
+        public override void EnterMemberdeclaration([NotNull] CPPCXParser.MemberdeclarationContext context)
+        {
+            if (_classes.Count == 0 || context.functionDefinition() != null) return;
+
+            var frame = _classes.Peek();
+            var declSpecs = context.declSpecifierSeq()?.declSpecifier() ?? Array.Empty<CPPCXParser.DeclSpecifierContext>();
+            if (declSpecs.Any(o => o.typeSpecifier()?.classSpecifier() != null || o.typeSpecifier()?.enumSpecifier() != null)) return;
+
+            var memberDecls = context.memberDeclaratorList()?.memberDeclarator();
+            if (memberDecls == null)
+            {
+                // `int m_value;` may be parsed as two decl specifiers, like global variables are.
+                if (declSpecs.Length < 2) return;
+
+                frame.Class.Fields.Add(new CxField
+                {
+                    TypedName = new CxTypedName(new CxType(_names.Get(declSpecs[^2])), _names.Get(declSpecs[^1])),
+                    Visibility = frame.Visibility,
+                    IsStatic = IsStatic(declSpecs),
+                });
+                return;
+            }
+
+            var type = _names.Get(declSpecs.LastOrDefault(o => o.typeSpecifier() != null));
+
+            foreach (var memberDecl in memberDecls)
+            {
+                var declarator = memberDecl.declarator();
+                if (declarator == null) continue;
+
+                var nameAndParms = declarator.pointerDeclarator()?.noPointerDeclarator();
+                var parms = nameAndParms?.parametersAndQualifiers() ?? declarator.parametersAndQualifiers();
+
+                if (parms != null)
+                {
+                    var nameCtx = nameAndParms?.noPointerDeclarator() ?? declarator.noPointerDeclarator();
+                    var parameterDecls = parms.parameterDeclarationClause()?.parameterDeclarationList()?.parameterDeclaration();
+
+                    frame.Class.Functions.Add(new CxMemberFunction
+                    {
+                        Function = new CxFunction
+                        {
+                            Name = _names.Get(nameCtx),
+                            ReturnType = type == null ? null : new CxType(type),
+                            Parameters = parameterDecls == null ? new List<CxParameter>() : ToCxParameters(_parameterAnalyzer.Visit(parameterDecls)),
+                            IsStatic = IsStatic(declSpecs),
+                            Span = CxSourceSpan.Of(context),
+                        },
+                        Visibility = frame.Visibility,
+                        IsVirtual = IsVirtual(declSpecs),
+                        IsOverriden = IsOverriden(memberDecl.virtualSpecifierSeq()),
+                    });
+                }
+                else
+                {
+                    var initializer = memberDecl.braceOrEqualInitializer();
+                    frame.Class.Fields.Add(new CxField
+                    {
+                        TypedName = new CxTypedName(new CxType(type), _names.Get(declarator.GetCodeMemory().Span.Trim(" *^&".AsSpan()))),
+                        InitValue = initializer == null ? null : (initializer.initializerClause() ?? (ParserRuleContext)initializer.bracedInitList()).GetCodeText(),
+                        Visibility = frame.Visibility,
+                        IsStatic = IsStatic(declSpecs),
+                    });
+                }
+            }
+        }
+
+        private CxNamespace GetOrAddNamespace(CxNamespace parent, string name)
+        {
+            if (!_nestedNamespaces.TryGetValue(parent, out var children))
+            {
+                children = new Dictionary<string, CxNamespace>();
+                _nestedNamespaces.Add(parent, children);
+            }
+
+            if (!children.TryGetValue(name, out var ns))
+            {
+                ns = new CxNamespace { Namespace = name };
+                children.Add(name, ns);
+                parent.NestedNamespaces.Add(ns);
+            }
+
+            return ns;
+        }
+
+        private CxCode CreateCode(ParserRuleContext context)
+        {
+            return new CxCode
+            {
+                Context = Detached ? null : context,
+                SourceName = context.Start.InputStream?.SourceName,
+                Span = CxSourceSpan.Of(context),
+                RuleIndex = context.RuleIndex,
+                SourceLength = _sourceLength,
+                SourceHash = _sourceHash,
+            };
+        }
+
+        // Hashed once per file, so detached code blocks can tell when their file has changed.
+        private static (int Length, string Hash) GetSourceStamp(ICharStream input)
+        {
+            if (input == null) return (-1, null);
+            if (input is CxSourceText source) return (source.Size, CxSourceText.ComputeHash(source.Memory.Span));
+
+            var text = input.Size > 0 ? input.GetText(Interval.Of(0, input.Size - 1)) : string.Empty;
+            return (text.Length, CxSourceText.ComputeHash(text));
+        }
+
+        private static CxVisibility ToVisibility(CPPCXParser.AccessSpecifierContext context)
+        {
+            if (context.Private() != null) return CxVisibility.Private;
+            if (context.Protected() != null) return CxVisibility.Protected;
+            if (context.Internal() != null) return CxVisibility.Internal;
+            return CxVisibility.Public;
+        }
+
+        private static List<CxParameter> ToCxParameters(List<ParameterAnalyzer.Parameter> parameters)
+        {
+            var res = new List<CxParameter>(parameters.Count);
+            foreach (var parameter in parameters)
+            {
+                res.Add(new CxParameter(new CxTypedName(new CxType(parameter.Type), parameter.Name), parameter.DefaultValue));
+            }
+
+            return res;
+        }
+
+        private static string GetInitValue(CPPCXParser.InitializerContext context)
+        {
+            if (context == null) return null;
+
+            var braceOrEqual = context.braceOrEqualInitializer();
+            if (braceOrEqual != null)
+            {
+                return (braceOrEqual.initializerClause() ?? (ParserRuleContext)braceOrEqual.bracedInitList()).GetCodeText();
+            }
+
+            return context.expressionList().GetCodeText();
+        }
+
+        private static bool IsStatic(CPPCXParser.DeclSpecifierContext[] declSpecs)
+        {
+            return declSpecs != null && declSpecs.Any(o => o.storageClassSpecifier()?.Static() != null);
+        }
+
+        private static bool IsVirtual(CPPCXParser.DeclSpecifierContext[] declSpecs)
+        {
+            return declSpecs != null && declSpecs.Any(o => o.functionSpecifier()?.Virtual() != null);
+        }
+
+        private static bool IsOverriden(CPPCXParser.VirtualSpecifierSeqContext context)
+        {
+            return context != null && context.virtualSpecifier().Any(o => o.Override() != null);
+        }
+    }
+}
@@ -1,5 +1,6 @@
 ﻿using Antlr4.Runtime.Misc;
 using Antlr4.Runtime.Tree;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Linq;
@@ -10,7 +11,8 @@ namespace cppcx.Core.Analyzers
 {
     public class FunctionDeclarationAnalyzer
     {
-        private static ParameterAnalyzer _analyzer = new ParameterAnalyzer();
+        private readonly NameTable _names;
+        private readonly ParameterAnalyzer _analyzer;
 
         public class FunctionDeclaration
         {
@@ -19,13 +21,19 @@ namespace cppcx.Core.Analyzers
             public List<ParameterAnalyzer.Parameter> Parameters { get; init; } = new List<ParameterAnalyzer.Parameter>();
         }
 
+        public FunctionDeclarationAnalyzer(NameTable names = null)
+        {
+            _names = names ?? new NameTable();
+            _analyzer = new ParameterAnalyzer(_names);
+        }
+
         public FunctionDeclaration Visit([NotNull] CPPCXParser.SimpleDeclarationContext context)
         {
-            var retType = context.declSpecifierSeq().GetText();
+            var retType = _names.Get(context.declSpecifierSeq());
 
             var nameAndParms = context.initDeclaratorList().initDeclarator()[0].declarator().pointerDeclarator().noPointerDeclarator();
 
-            var name = nameAndParms.noPointerDeclarator().GetText();
+            var name = _names.Get(nameAndParms.noPointerDeclarator());
             var parameterDecls = nameAndParms.parametersAndQualifiers()?.parameterDeclarationClause()?.parameterDeclarationList()?.parameterDeclaration();
 
             var res = new FunctionDeclaration
@@ -1,4 +1,6 @@
-﻿using Antlr4.Runtime.Misc;
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Linq;
@@ -9,27 +11,107 @@ namespace cppcx.Core.Analyzers
 {
     public class FunctionDefinitionAnalyzer
     {
+        private readonly NameTable _names;
+        private readonly ParameterAnalyzer _analyzer;
+
         public class FunctionDefinition
         {
+            private CPPCXParser.StatementSeqContext _statements;
+            private Func<CPPCXParser.StatementSeqContext> _statementsLoader;
+
             public string ClassName { get; set; } = null;
             public string Name { get; set; }
             public string ReturnType { get; set; }
             public List<ParameterAnalyzer.Parameter> Parameters { get; init; } = new List<ParameterAnalyzer.Parameter>();
-            public CPPCXParser.StatementSeqContext Statements { get; set; }
+
+            public CPPCXParser.StatementSeqContext Statements
+            {
+                get
+                {
+                    var loader = _statementsLoader;
+                    if (loader != null)
+                    {
+                        _statements = loader();
+                        _statementsLoader = null;
+                    }
+                    return _statements;
+                }
+                set
+                {
+                    _statements = value;
+                    _statementsLoader = null;
+                }
+            }
+
+            public bool IsStatementsLoaded => _statementsLoader == null;
+
+            public Func<CPPCXParser.StatementSeqContext> StatementsLoader
+            {
+                init => _statementsLoader = value;
+            }
         }
 
-        public void Visit([NotNull] CPPCXParser.FunctionDefinitionContext context)
+        private readonly IReadOnlyDictionary<int, SkippedFunctionBody> _skippedBodies;
+
+        public FunctionDefinitionAnalyzer(IReadOnlyDictionary<int, SkippedFunctionBody> skippedBodies = null, NameTable names = null)
         {
-            string retType = null;
-            var retTypeAndClassName = context.declSpecifierSeq();
-            var className = retTypeAndClassName?.declSpecifier()?.Last()?.GetText();
-            if (retTypeAndClassName.ChildCount == 2)
+            _skippedBodies = skippedBodies;
+            _names = names ?? new NameTable();
+            _analyzer = new ParameterAnalyzer(_names);
+        }
+
+        public FunctionDefinition Visit([NotNull] CPPCXParser.FunctionDefinitionContext context)
+        {
+            var declSpecs = context.declSpecifierSeq()?.declSpecifier() ?? Array.Empty<CPPCXParser.DeclSpecifierContext>();
+
+            var nameAndParms = context.declarator().pointerDeclarator()?.noPointerDeclarator();
+            var nameCtx = nameAndParms?.parametersAndQualifiers() != null ? nameAndParms.noPointerDeclarator() : nameAndParms;
+            var qualifiedName = _names.Get(nameCtx ?? (ParserRuleContext)context.declarator());
+
+            // Out-of-line definitions like `void App::OnLaunched()` may be split as
+            // declSpecifierSeq `void App` and declarator `::OnLaunched()`.
+            string className = null;
+            var name = qualifiedName;
+            var sep = qualifiedName.LastIndexOf("::", StringComparison.Ordinal);
+            if (sep > 0)
+            {
+                className = _names.Get(qualifiedName.AsSpan(0, sep).Trim());
+                name = _names.Get(qualifiedName.AsSpan(sep + 2).Trim());
+            }
+            else if (sep == 0)
+            {
+                name = _names.Get(qualifiedName.AsSpan(2).Trim());
+                if (declSpecs.Length > 0)
+                {
+                    className = _names.Get(declSpecs[^1]);
+                    declSpecs = declSpecs[..^1];
+                }
+            }
+
+            var parameterDecls = nameAndParms?.parametersAndQualifiers()?.parameterDeclarationClause()?.parameterDeclarationList()?.parameterDeclaration();
+
+            var res = new FunctionDefinition
+            {
+                ClassName = className,
+                Name = name,
+                ReturnType = declSpecs.Length > 0 ? _names.Get(declSpecs[^1]) : null,
+                Parameters = parameterDecls == null ? new List<ParameterAnalyzer.Parameter>() : _analyzer.Visit(parameterDecls),
+                StatementsLoader = GetStatementsLoader(context.functionBody()?.compoundStatement()),
+            };
+
+            return res;
+        }
+
+        private Func<CPPCXParser.StatementSeqContext> GetStatementsLoader(CPPCXParser.CompoundStatementContext body)
+        {
+            if (body == null) return () => null;
+
+            if (_skippedBodies != null && _skippedBodies.TryGetValue(body.Start.StartIndex, out var skipped))
             {
-                retType = retTypeAndClassName?.declSpecifier()?.First()?.GetText();
+                return () => skipped.Parse().statementSeq();
             }
 
-            var name = context.declarator().GetText().Trim(':');
-            throw new NotImplementedException();
+            return () => body.statementSeq();
         }
     }
 }
@@ -1,6 +1,7 @@
 ﻿using Antlr4.Runtime.Misc;
 using Antlr4.Runtime.Tree;
 using cppcx.Core.Models;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Diagnostics;
@@ -20,6 +21,13 @@ namespace cppcx.Core.Analyzers
             public CPPCXParser.InitializerContext InitContext { get; set; }
         }
 
+        private readonly NameTable _names;
+
+        public GlobalVariableAnalyzer(NameTable names = null)
+        {
+            _names = names ?? new NameTable();
+        }
+
         public IEnumerable<GlobalVariable> Visit([NotNull] CPPCXParser.SimpleDeclarationContext context)
         {
             var decls = context.declSpecifierSeq()?.declSpecifier();
@@ -31,14 +39,9 @@ namespace cppcx.Core.Analyzers
             {
                 Debug.Assert(decls.Length >= 2);
 
-                var name = decls[^1].GetText();
-                var type = decls[^2].GetText();
-                var isExtern = false;
-
-                if (decls.Length > 2)
-                {
-                    isExtern = decls[0].GetText() == "extern";
-                }
+                var name = _names.Get(decls[^1]);
+                var type = _names.Get(decls[^2]);
+                var isExtern = decls.Length > 2 && IsExtern(decls[0]);
 
                 yield return new GlobalVariable
                 {
@@ -49,25 +52,25 @@ namespace cppcx.Core.Analyzers
             }
             else
             {
-                var type = decls[^1].GetText();
-                var isExtern = false;
-
-                if (decls.Length > 1)
-                {
-                    isExtern = decls[0].GetText() == "extern";
-                }
+                var type = _names.Get(decls[^1]);
+                var isExtern = decls.Length > 1 && IsExtern(decls[0]);
 
                 foreach (var initDecl in initDecls)
                 {
                     yield return new GlobalVariable
                     {
                         Type = type,
-                        Name = initDecl.declarator().GetText(),
+                        Name = _names.Get(initDecl.declarator()),
                         IsExtern = isExtern,
                         InitContext = initDecl.initializer(),
                     };
                 }
             }
         }
+
+        private static bool IsExtern(CPPCXParser.DeclSpecifierContext context)
+        {
+            return context.storageClassSpecifier()?.Extern() != null;
+        }
     }
 }
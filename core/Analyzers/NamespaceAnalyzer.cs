@@ -1,6 +1,7 @@
 ﻿using Antlr4.Runtime.Misc;
 using Antlr4.Runtime.Tree;
 using cppcx.Core.Models;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Diagnostics;
@@ -47,6 +48,13 @@ namespace cppcx.Core.Analyzers
             }
         }
 
+        private readonly NameTable _names;
+
+        public NamespaceAnalyzer(NameTable names = null)
+        {
+            _names = names ?? new NameTable();
+        }
+
         public override Namespace VisitNamespaceDefinition([NotNull] CPPCXParser.NamespaceDefinitionContext context)
         {
             var childNs = VisitChildren(context);
@@ -59,10 +67,10 @@ namespace cppcx.Core.Analyzers
             var nestedNames = qualifiedNs.nestedNameSpecifier();
             if (nestedNames != null)
             {
-                nsParts.AddRange(nestedNames.GetText().Split("::", StringSplitOptions.RemoveEmptyEntries));
+                _names.GetQualifiedNameParts(nestedNames, nsParts);
             }
 
-            nsParts.Add(qualifiedNs.namespaceName().GetText());
+            nsParts.Add(_names.Get(qualifiedNs.namespaceName()));
 
             var res = new Namespace { Name = string.Empty };
 
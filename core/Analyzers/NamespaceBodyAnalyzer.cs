@@ -1,5 +1,6 @@
 ﻿using Antlr4.Runtime.Misc;
 using Antlr4.Runtime.Tree;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Diagnostics;
@@ -15,28 +16,28 @@ namespace cppcx.Core.Analyzers
         public class GlobalVariableDeclaration
         {
             public CPPCXParser.SimpleDeclarationContext Context;
-            public string Text => Context?.GetText();
+            public string Text => Context?.GetSourceText();
             public override string ToString() => Text;
         }
 
         public class ClassDeclaration
         {
             public CPPCXParser.ClassSpecifierContext Context;
-            public string Text => Context?.GetText();
+            public string Text => Context?.GetSourceText();
             public override string ToString() => Text;
         }
 
         public class FunctionDeclaration
         {
             public CPPCXParser.SimpleDeclarationContext Context;
-            public string Text => Context?.GetText();
+            public string Text => Context?.GetSourceText();
             public override string ToString() => Text;
         }
 
         public class FunctionDefinition
         {
             public CPPCXParser.FunctionDefinitionContext Context;
-            public string Text => Context?.GetText();
+            public string Text => Context?.GetSourceText();
             public override string ToString() => Text;
         }
 
@@ -61,12 +62,12 @@ namespace cppcx.Core.Analyzers
             }
         }
 
-        private enum DeclarationType
+        internal enum DeclarationType
         {
             Unknown, Variable, Function
         }
 
-        private DeclarationType IsVariableDeclaration(CPPCXParser.SimpleDeclarationContext context)
+        internal static DeclarationType IsVariableDeclaration(CPPCXParser.SimpleDeclarationContext context)
         {
             var decls = context.declSpecifierSeq()?.declSpecifier();
             if (decls == null) return DeclarationType.Unknown;
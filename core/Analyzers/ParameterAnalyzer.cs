@@ -1,4 +1,6 @@
-﻿using Antlr4.Runtime.Misc;
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
 using System.Linq;
@@ -16,15 +18,29 @@ namespace cppcx.Core.Analyzers
             public string DefaultValue { get; set; }
         }
 
+        private readonly NameTable _names;
+
+        public ParameterAnalyzer(NameTable names = null)
+        {
+            _names = names ?? new NameTable();
+        }
+
         private Parameter VisitParameterDeclaration([NotNull] CPPCXParser.ParameterDeclarationContext context)
         {
+            var declSpecs = context.declSpecifierSeq().declSpecifier();
             return new Parameter
             {
-                Type = context.declSpecifierSeq().declSpecifier()[0].GetText(),
-                Name = context.declSpecifierSeq().declSpecifier()[1].GetText().Trim('*', '^', '&'),
+                Type = _names.Get(declSpecs[0]),
+                Name = GetName(declSpecs.Length > 1 ? declSpecs[1] : context.declarator()),
             };
         }
 
+        private string GetName(ParserRuleContext context)
+        {
+            if (context == null) return null;
+            return _names.Get(context.GetCodeMemory().Span.Trim(" *^&".AsSpan()));
+        }
+
         public List<Parameter> Visit([NotNull] IEnumerable<CPPCXParser.ParameterDeclarationContext> contexts)
         {
             var res = new List<Parameter>();
@@ -0,0 +1,54 @@
+﻿using Antlr4.Runtime.Misc;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Analyzers
+{
+    public class TranslationUnitAnalyzer
+    {
+        public class TranslationUnit
+        {
+            public NamespaceAnalyzer.Namespace Root { get; init; }
+            public List<(NamespaceAnalyzer.Namespace Namespace, NamespaceBodyAnalyzer.NamespaceBody Body)> Bodies { get; init; }
+                = new List<(NamespaceAnalyzer.Namespace, NamespaceBodyAnalyzer.NamespaceBody)>();
+
+            public int DeclarationCount => Bodies.Sum(o => o.Body.GlobalVariables.Count + o.Body.Classes.Count + o.Body.FunctionDeclarations.Count + o.Body.FunctionDefinitions.Count);
+        }
+
+        public TranslationUnit Visit([NotNull] CPPCXParser.TranslationUnitContext context)
+        {
+            var root = new NamespaceAnalyzer().Visit(context) ?? new NamespaceAnalyzer.Namespace { Name = string.Empty };
+            var res = new TranslationUnit { Root = root };
+
+            var globalDecls = context.declarationseq();
+            if (globalDecls != null)
+            {
+                res.Bodies.Add((root, new NamespaceBodyAnalyzer().Visit(globalDecls) ?? new NamespaceBodyAnalyzer.NamespaceBody()));
+            }
+
+            VisitNamespace(root, res);
+            return res;
+        }
+
+        private void VisitNamespace(NamespaceAnalyzer.Namespace ns, TranslationUnit res)
+        {
+            foreach (var nested in ns.NestedNamespaces.Values)
+            {
+                var body = new NamespaceBodyAnalyzer.NamespaceBody();
+                foreach (var ctx in nested.Contexts)
+                {
+                    if (ctx == null) continue;
+
+                    var part = new NamespaceBodyAnalyzer().Visit(ctx);
+                    if (part != null) body.MergeFrom(part);
+                }
+
+                res.Bodies.Add((nested, body));
+                VisitNamespace(nested, res);
+            }
+        }
+    }
+}
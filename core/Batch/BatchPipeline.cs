@@ -0,0 +1,276 @@
+﻿using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Channels;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Batch
+{
+    // Runs a batch as read -> lex -> parse -> analyze stages connected by bounded channels.
+    // Each stage has its own degree of parallelism, so slow I/O overlaps with lexing and
+    // parsing, and at most QueueCapacity files wait between two stages.
+    // MapFiles and HeaderCache are not supported and have to be unset; files are read
+    // asynchronously instead.
+    public class BatchPipeline
+    {
+        public class Options : BatchRunner.Options
+        {
+            public int ReadParallelism { get; set; } = 4;
+            public int LexParallelism { get; set; } = Math.Max(1, Environment.ProcessorCount / 4);
+            public int ParseParallelism { get; set; } = Math.Max(1, Environment.ProcessorCount / 2);
+            public int AnalyzeParallelism { get; set; } = Math.Max(1, Environment.ProcessorCount / 4);
+            public int QueueCapacity { get; set; } = 16;
+        }
+
+        public class StageStats
+        {
+            private long _items = 0;
+            private long _busyTicks = 0;
+            private long _blockedTicks = 0;
+            private long _queueSamples = 0;
+            private long _queueTotal = 0;
+            private int _queueMax = 0;
+
+            public string Name { get; init; }
+            public int Parallelism { get; init; }
+
+            public long Items => Interlocked.Read(ref _items);
+            // Time spent working on files.
+            public TimeSpan BusyTime => TimeSpan.FromTicks(Interlocked.Read(ref _busyTicks));
+            // Time spent waiting for room in the next stage's queue, i.e. a later stage is slower.
+            public TimeSpan BlockedTime => TimeSpan.FromTicks(Interlocked.Read(ref _blockedTicks));
+            // Files waiting in the queue in front of this stage, sampled whenever one is taken.
+            public double AverageQueueLength => _queueSamples == 0 ? 0 : (double)_queueTotal / _queueSamples;
+            public int MaxQueueLength => _queueMax;
+
+            public double Utilization(TimeSpan wallTime)
+            {
+                return wallTime <= TimeSpan.Zero ? 0 : BusyTime.TotalSeconds / (wallTime.TotalSeconds * Parallelism);
+            }
+
+            internal void RecordQueue(int length)
+            {
+                Interlocked.Increment(ref _queueSamples);
+                Interlocked.Add(ref _queueTotal, length);
+
+                for (var max = _queueMax; length > max; max = _queueMax)
+                {
+                    if (Interlocked.CompareExchange(ref _queueMax, length, max) == max) break;
+                }
+            }
+
+            internal void RecordItem(TimeSpan busy, TimeSpan blocked)
+            {
+                Interlocked.Increment(ref _items);
+                Interlocked.Add(ref _busyTicks, busy.Ticks);
+                Interlocked.Add(ref _blockedTicks, blocked.Ticks);
+            }
+        }
+
+        public class Result : BatchRunner.Result
+        {
+            public List<StageStats> Stages { get; init; } = new List<StageStats>();
+        }
+
+        private class WorkItem
+        {
+            public FileInfo File;
+            public TimeSpan Elapsed;
+            public CxSourceText Source;
+            public CxLexResult Lexed;
+            public CxParseResult Parsed;
+            public CxNamespace Model;
+            public Exception Exception;
+        }
+
+        private readonly Options _options;
+        private readonly CxParserPool _pool;
+
+        public BatchPipeline(Options options = null)
+        {
+            _options = options ?? new Options();
+            if (_options.MapFiles || _options.HeaderCache != null)
+            {
+                throw new ArgumentException($"{nameof(Options.MapFiles)} and {nameof(Options.HeaderCache)} are not supported by {nameof(BatchPipeline)}", nameof(options));
+            }
+            _pool = _options.Pool ?? new CxParserPool(_options.Parse);
+        }
+
+        public Result Run(IEnumerable<string> files, Action<BatchRunner.FileResult> onFileCompleted = null)
+        {
+            return RunAsync(files, onFileCompleted).GetAwaiter().GetResult();
+        }
+
+        public async Task<Result> RunAsync(IEnumerable<string> files, Action<BatchRunner.FileResult> onFileCompleted = null)
+        {
+            // Largest files first, like BatchRunner, so a huge file doesn't hold up the end of the run.
+            var ordered = files
+                .Select(o => new FileInfo(o))
+                .OrderByDescending(o => o.Exists ? o.Length : 0)
+                .ToList();
+
+            var stages = new List<StageStats>
+            {
+                new StageStats { Name = "read", Parallelism = _options.ReadParallelism },
+                new StageStats { Name = "lex", Parallelism = _options.LexParallelism },
+                new StageStats { Name = "parse", Parallelism = _options.ParseParallelism },
+            };
+            if (_options.Analyze)
+            {
+                stages.Add(new StageStats { Name = "analyze", Parallelism = _options.AnalyzeParallelism });
+            }
+
+            var queues = Enumerable.Range(0, stages.Count + 1)
+                .Select(_ => Channel.CreateBounded<WorkItem>(new BoundedChannelOptions(_options.QueueCapacity)
+                {
+                    SingleWriter = false,
+                    SingleReader = false,
+                }))
+                .ToList();
+
+            var sw = Stopwatch.StartNew();
+            var tasks = new List<Task>
+            {
+                Feed(ordered, queues[0].Writer),
+                RunStage(stages[0], queues[0].Reader, queues[1].Writer, ReadAsync),
+                RunStage(stages[1], queues[1].Reader, queues[2].Writer, Lex),
+                RunStage(stages[2], queues[2].Reader, queues[3].Writer, Parse),
+            };
+            if (_options.Analyze)
+            {
+                tasks.Add(RunStage(stages[3], queues[3].Reader, queues[4].Writer, Analyze));
+            }
+
+            var results = new List<BatchRunner.FileResult>();
+            await foreach (var item in queues[^1].Reader.ReadAllAsync())
+            {
+                var res = ToFileResult(item);
+                results.Add(res);
+                onFileCompleted?.Invoke(res);
+            }
+            await Task.WhenAll(tasks);
+
+            return new Result
+            {
+                Files = results.OrderBy(o => o.Path, StringComparer.Ordinal).ToList(),
+                WallTime = sw.Elapsed,
+                Stages = stages,
+            };
+        }
+
+        private static async Task Feed(List<FileInfo> files, ChannelWriter<WorkItem> output)
+        {
+            try
+            {
+                foreach (var file in files)
+                {
+                    await output.WriteAsync(new WorkItem { File = file });
+                }
+            }
+            finally
+            {
+                output.Complete();
+            }
+        }
+
+        private static async Task RunStage(StageStats stats, ChannelReader<WorkItem> input, ChannelWriter<WorkItem> output, Func<WorkItem, ValueTask> work)
+        {
+            var workers = Enumerable.Range(0, Math.Max(1, stats.Parallelism)).Select(_ => Task.Run(async () =>
+            {
+                await foreach (var item in input.ReadAllAsync())
+                {
+                    stats.RecordQueue(input.Count);
+
+                    var sw = Stopwatch.StartNew();
+                    if (item.Exception == null)
+                    {
+                        try
+                        {
+                            await work(item);
+                        }
+                        catch (Exception e)
+                        {
+                            item.Exception = e;
+                        }
+                    }
+                    var busy = sw.Elapsed;
+                    item.Elapsed += busy;
+
+                    sw.Restart();
+                    await output.WriteAsync(item);
+                    stats.RecordItem(busy, sw.Elapsed);
+                }
+            }));
+
+            try
+            {
+                await Task.WhenAll(workers);
+            }
+            finally
+            {
+                output.Complete();
+            }
+        }
+
+        private static async ValueTask ReadAsync(WorkItem item)
+        {
+            var text = await File.ReadAllTextAsync(item.File.FullName);
+            item.Source = new CxSourceText(text, item.File.FullName);
+        }
+
+        private ValueTask Lex(WorkItem item)
+        {
+            item.Lexed = _pool.Lex(item.Source);
+            item.Source = null;
+            return ValueTask.CompletedTask;
+        }
+
+        private ValueTask Parse(WorkItem item)
+        {
+            item.Parsed = _pool.Parse(item.Lexed);
+            item.Lexed = null;
+            return ValueTask.CompletedTask;
+        }
+
+        private ValueTask Analyze(WorkItem item)
+        {
+            item.Model = BatchRunner.Analyze(item.Parsed);
+            _options.ModelOutput?.Add(item.File.FullName, item.Model);
+            return ValueTask.CompletedTask;
+        }
+
+        private BatchRunner.FileResult ToFileResult(WorkItem item)
+        {
+            var bytes = item.File.Exists ? item.File.Length : 0;
+            if (item.Exception != null)
+            {
+                return new BatchRunner.FileResult
+                {
+                    Path = item.File.FullName,
+                    Bytes = bytes,
+                    Elapsed = item.Elapsed,
+                    Exception = item.Exception,
+                };
+            }
+
+            return new BatchRunner.FileResult
+            {
+                Path = item.File.FullName,
+                Bytes = bytes,
+                Elapsed = item.Elapsed,
+                SyntaxErrors = item.Parsed.SyntaxErrors.Count,
+                UsedLlFallback = item.Parsed.UsedLlFallback,
+                SkippedRegions = item.Parsed.SkippedRegions.Count,
+                BudgetExceeded = item.Parsed.BudgetExceeded,
+                Declarations = item.Model == null ? 0 : BatchRunner.CountDeclarations(item.Model),
+                Model = _options.KeepModels ? item.Model : null,
+            };
+        }
+    }
+}
@@ -0,0 +1,173 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Caching;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using cppcx.Core.Serialization;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Batch
+{
+    public class BatchRunner
+    {
+        public class Options
+        {
+            public int MaxDegreeOfParallelism { get; set; } = Environment.ProcessorCount;
+            public bool Analyze { get; set; } = true;
+            public bool KeepModels { get; set; } = false;
+            public bool MapFiles { get; set; } = false;
+            public CxParseOptions Parse { get; set; } = new CxParseOptions();
+            // Shared across runs to keep parsers and their DFA cache warm; Parse is ignored then.
+            public CxParserPool Pool { get; set; } = null;
+            public HeaderModelCache HeaderCache { get; set; } = null;
+            // Models are streamed here as files complete, keyed by full path.
+            public CxModelWriter ModelOutput { get; set; } = null;
+        }
+
+        public class FileResult
+        {
+            public string Path { get; init; }
+            public long Bytes { get; init; }
+            public TimeSpan Elapsed { get; init; }
+            public int SyntaxErrors { get; init; }
+            public bool UsedLlFallback { get; init; }
+            public int SkippedRegions { get; init; }
+            public bool BudgetExceeded { get; init; }
+            public bool FromCache { get; init; }
+            public int Declarations { get; init; }
+            public CxNamespace Model { get; init; }
+            public Exception Exception { get; init; }
+        }
+
+        public class Result
+        {
+            public List<FileResult> Files { get; init; } = new List<FileResult>();
+            public TimeSpan WallTime { get; init; }
+
+            public long TotalBytes => Files.Sum(o => o.Bytes);
+            public TimeSpan TotalFileTime => TimeSpan.FromTicks(Files.Sum(o => o.Elapsed.Ticks));
+            public int LlFallbacks => Files.Count(o => o.UsedLlFallback);
+            public int SkippedRegions => Files.Sum(o => o.SkippedRegions);
+            public int BudgetsExceeded => Files.Count(o => o.BudgetExceeded);
+            public double FilesPerSecond => Files.Count / WallTime.TotalSeconds;
+            public double MegabytesPerSecond => TotalBytes / (1024.0 * 1024.0) / WallTime.TotalSeconds;
+        }
+
+        private readonly Options _options;
+        private readonly CxParserPool _pool;
+
+        public BatchRunner(Options options = null)
+        {
+            _options = options ?? new Options();
+            _pool = _options.Pool ?? new CxParserPool(_options.Parse);
+        }
+
+        public Result Run(IEnumerable<string> files, Action<FileResult> onFileCompleted = null)
+        {
+            // Largest files first, handed out one at a time, so a huge file starts early
+            // instead of ending up last in some worker's pre-assigned chunk.
+            var ordered = files
+                .Select(o => new FileInfo(o))
+                .OrderByDescending(o => o.Exists ? o.Length : 0)
+                .ToList();
+
+            var results = new ConcurrentBag<FileResult>();
+            var sw = Stopwatch.StartNew();
+
+            Parallel.ForEach(
+                Partitioner.Create(ordered, EnumerablePartitionerOptions.NoBuffering),
+                new ParallelOptions { MaxDegreeOfParallelism = _options.MaxDegreeOfParallelism },
+                file =>
+                {
+                    var res = ProcessFile(file);
+                    results.Add(res);
+                    onFileCompleted?.Invoke(res);
+                });
+
+            return new Result
+            {
+                Files = results.OrderBy(o => o.Path, StringComparer.Ordinal).ToList(),
+                WallTime = sw.Elapsed,
+            };
+        }
+
+        private FileResult ProcessFile(FileInfo file)
+        {
+            var sw = Stopwatch.StartNew();
+            try
+            {
+                if (_options.Analyze && _options.HeaderCache != null && HeaderModelCache.IsHeader(file.Name))
+                {
+                    return ProcessHeader(file, sw);
+                }
+
+                using var mapped = _options.MapFiles ? CxMappedSourceText.Open(file.FullName) : null;
+                var parsed = mapped != null ? _pool.Parse(mapped) : _pool.ParseFile(file.FullName);
+                var model = _options.Analyze ? Analyze(parsed) : null;
+                if (model != null) _options.ModelOutput?.Add(file.FullName, model);
+
+                return new FileResult
+                {
+                    Path = file.FullName,
+                    Bytes = file.Length,
+                    Elapsed = sw.Elapsed,
+                    SyntaxErrors = parsed.SyntaxErrors.Count,
+                    UsedLlFallback = parsed.UsedLlFallback,
+                    SkippedRegions = parsed.SkippedRegions.Count,
+                    BudgetExceeded = parsed.BudgetExceeded,
+                    Declarations = model == null ? 0 : CountDeclarations(model),
+                    Model = _options.KeepModels ? model : null,
+                };
+            }
+            catch (Exception e)
+            {
+                return new FileResult
+                {
+                    Path = file.FullName,
+                    Bytes = file.Exists ? file.Length : 0,
+                    Elapsed = sw.Elapsed,
+                    Exception = e,
+                };
+            }
+        }
+
+        private FileResult ProcessHeader(FileInfo file, Stopwatch sw)
+        {
+            var model = _options.HeaderCache.GetOrAnalyze(file.FullName, source => Analyze(_pool.Parse(source)), out var cached);
+            _options.ModelOutput?.Add(file.FullName, model);
+
+            return new FileResult
+            {
+                Path = file.FullName,
+                Bytes = file.Length,
+                Elapsed = sw.Elapsed,
+                FromCache = cached,
+                Declarations = CountDeclarations(model),
+                Model = _options.KeepModels ? model : null,
+            };
+        }
+
+        internal static CxNamespace Analyze(CxParseResult parsed)
+        {
+            return new CxModelAnalyzer(parsed.SkippedBodies) { Detached = true }.Visit(parsed.TranslationUnit);
+        }
+
+        internal static int CountDeclarations(CxNamespace ns)
+        {
+            var res = ns.GlobalVariables.Count + ns.Functions.Count + ns.Classes.Count;
+            foreach (var nested in ns.NestedNamespaces)
+            {
+                res += CountDeclarations(nested);
+            }
+
+            return res;
+        }
+    }
+}
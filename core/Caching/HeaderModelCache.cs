@@ -0,0 +1,195 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Caching
+{
+    // Caches analyzed (detached) header models by content hash, so a header shared by many
+    // translation units is parsed once per content instead of once per includer. Optionally
+    // persisted as one file per hash, so unchanged headers are not parsed again next run.
+    //
+    // Models are shared per path: another path with the same content gets its own copy, whose
+    // code blocks are re-parsed from that path.
+    public class HeaderModelCache
+    {
+        public const int FormatVersion = 2;
+
+        private class Entry
+        {
+            public CxNamespace Model { get; init; }
+            public string SourceName { get; init; }
+        }
+
+        private readonly ConcurrentDictionary<string, Lazy<Entry>> _models = new ConcurrentDictionary<string, Lazy<Entry>>();
+        private readonly ConcurrentDictionary<(string Hash, string Path), Lazy<CxNamespace>> _copies = new ConcurrentDictionary<(string Hash, string Path), Lazy<CxNamespace>>();
+        private readonly string _directory;
+        private long _hits = 0;
+        private long _misses = 0;
+        private long _diskHits = 0;
+
+        public long Hits => Interlocked.Read(ref _hits);
+        public long Misses => Interlocked.Read(ref _misses);
+        public long DiskHits => Interlocked.Read(ref _diskHits);
+        public int Count => _models.Count;
+
+        public HeaderModelCache(string directory = null)
+        {
+            _directory = directory;
+            if (_directory != null)
+            {
+                Directory.CreateDirectory(_directory);
+            }
+        }
+
+        public static bool IsHeader(string path)
+        {
+            var ext = Path.GetExtension(path);
+            return ext.Equals(".h", StringComparison.OrdinalIgnoreCase)
+                || ext.Equals(".hpp", StringComparison.OrdinalIgnoreCase)
+                || ext.Equals(".hxx", StringComparison.OrdinalIgnoreCase);
+        }
+
+        public static string ComputeHash(ReadOnlySpan<byte> content)
+        {
+            return Convert.ToHexString(SHA256.HashData(content));
+        }
+
+        public CxNamespace GetOrAnalyze(string path, CxParserWorker worker)
+        {
+            return GetOrAnalyze(path, worker, out _);
+        }
+
+        public CxNamespace GetOrAnalyze(string path, CxParserWorker worker, out bool cached)
+        {
+            return GetOrAnalyze(path, source =>
+            {
+                var parsed = worker.Parse(source);
+                return new CxModelAnalyzer(parsed.SkippedBodies) { Detached = true }.Visit(parsed.TranslationUnit);
+            }, out cached);
+        }
+
+        public CxNamespace GetOrAnalyze(string path, Func<CxSourceText, CxNamespace> analyze, out bool cached)
+        {
+            var content = File.ReadAllBytes(path);
+            var hash = ComputeHash(content);
+
+            var analyzed = false;
+            var lazy = _models.GetOrAdd(hash, key => new Lazy<Entry>(() =>
+            {
+                var res = LoadOrAnalyze(key, path, content, analyze, out var fromDisk);
+                analyzed = !fromDisk;
+                return new Entry { Model = res, SourceName = path };
+            }));
+
+            var entry = GetValue(_models, hash, lazy);
+            cached = !analyzed;
+            if (cached) Interlocked.Increment(ref _hits);
+            if (entry.SourceName == path) return entry.Model;
+
+            var copyKey = (hash, path);
+            var copy = _copies.GetOrAdd(copyKey, _ => new Lazy<CxNamespace>(() => Copy(entry.Model, path)));
+            return GetValue(_copies, copyKey, copy);
+        }
+
+        public bool Remove(string hash)
+        {
+            foreach (var key in _copies.Keys.Where(o => o.Hash == hash))
+            {
+                _copies.TryRemove(key, out _);
+            }
+            return _models.TryRemove(hash, out _);
+        }
+
+        // A Lazy keeps the exception of a failed analysis, so it is evicted to retry next time.
+        private static T GetValue<TKey, T>(ConcurrentDictionary<TKey, Lazy<T>> entries, TKey key, Lazy<T> lazy)
+        {
+            try
+            {
+                return lazy.Value;
+            }
+            catch
+            {
+                entries.TryRemove(new KeyValuePair<TKey, Lazy<T>>(key, lazy));
+                throw;
+            }
+        }
+
+        private static CxNamespace Copy(CxNamespace model, string path)
+        {
+            var res = JsonSerializer.Deserialize<CxNamespace>(JsonSerializer.SerializeToUtf8Bytes(model));
+            SetSourceName(res, path);
+            return res;
+        }
+
+        private static void SetSourceName(CxNamespace ns, string path)
+        {
+            foreach (var function in ns.Functions) SetSourceName(function, path);
+            foreach (var cls in ns.Classes) SetSourceName(cls, path);
+            foreach (var nested in ns.NestedNamespaces) SetSourceName(nested, path);
+        }
+
+        private static void SetSourceName(CxClass cls, string path)
+        {
+            foreach (var function in cls.Functions) SetSourceName(function.Function, path);
+            foreach (var nested in cls.NestedClasses) SetSourceName(nested, path);
+        }
+
+        private static void SetSourceName(CxFunction function, string path)
+        {
+            if (function?.Code != null) function.Code.SourceName = path;
+        }
+
+        private CxNamespace LoadOrAnalyze(string hash, string path, byte[] content, Func<CxSourceText, CxNamespace> analyze, out bool fromDisk)
+        {
+            fromDisk = false;
+            var cacheFile = _directory == null ? null : Path.Combine(_directory, $"{hash}.v{FormatVersion}.json");
+            if (cacheFile != null && File.Exists(cacheFile))
+            {
+                try
+                {
+                    var stored = JsonSerializer.Deserialize<CxNamespace>(File.ReadAllBytes(cacheFile));
+                    if (stored != null)
+                    {
+                        // Stored by whichever path analyzed it, possibly in an earlier run.
+                        SetSourceName(stored, path);
+                        Interlocked.Increment(ref _diskHits);
+                        fromDisk = true;
+                        return stored;
+                    }
+                }
+                catch (JsonException)
+                {
+                    // A corrupt or partially written entry is simply rebuilt.
+                }
+            }
+
+            Interlocked.Increment(ref _misses);
+
+            string text;
+            using (var reader = new StreamReader(new MemoryStream(content), Encoding.UTF8, detectEncodingFromByteOrderMarks: true))
+            {
+                text = reader.ReadToEnd();
+            }
+            var model = analyze(new CxSourceText(text, path));
+
+            if (cacheFile != null)
+            {
+                var tmpFile = $"{cacheFile}.{Guid.NewGuid():N}.tmp";
+                File.WriteAllBytes(tmpFile, JsonSerializer.SerializeToUtf8Bytes(model));
+                File.Move(tmpFile, cacheFile, overwrite: true);
+            }
+
+            return model;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+﻿using System;
+using System.Buffers.Binary;
+using System.Collections.Generic;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Text.Json.Serialization;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Diffing
+{
+    // 128 bits of a SHA-256, stable across processes and runs, unlike GetHashCode.
+    public readonly struct CxHash : IEquatable<CxHash>, IComparable<CxHash>
+    {
+        public ulong High { get; }
+        public ulong Low { get; }
+
+        [JsonConstructor]
+        public CxHash(ulong high, ulong low)
+        {
+            High = high;
+            Low = low;
+        }
+
+        public static CxHash Compute(ReadOnlySpan<byte> data)
+        {
+            Span<byte> hash = stackalloc byte[32];
+            SHA256.HashData(data, hash);
+            return new CxHash(BinaryPrimitives.ReadUInt64BigEndian(hash), BinaryPrimitives.ReadUInt64BigEndian(hash[8..]));
+        }
+
+        internal void WriteTo(Span<byte> destination)
+        {
+            BinaryPrimitives.WriteUInt64BigEndian(destination, High);
+            BinaryPrimitives.WriteUInt64BigEndian(destination[8..], Low);
+        }
+
+        public int CompareTo(CxHash other) => High != other.High ? High.CompareTo(other.High) : Low.CompareTo(other.Low);
+        public bool Equals(CxHash other) => High == other.High && Low == other.Low;
+        public override bool Equals(object obj) => obj is CxHash other && Equals(other);
+        public override int GetHashCode() => (int)Low;
+        public override string ToString() => $"{High:x16}{Low:x16}";
+
+        public static bool operator ==(CxHash left, CxHash right) => left.Equals(right);
+        public static bool operator !=(CxHash left, CxHash right) => !left.Equals(right);
+    }
+}
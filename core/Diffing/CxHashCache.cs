@@ -0,0 +1,114 @@
+﻿using cppcx.Core.Caching;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Diffing
+{
+    // Caches hash trees by file content, so a file is hashed once per content no matter how
+    // many revisions contain it. Persisted as one file per content hash, a later run only
+    // parses the files that changed since.
+    public class CxHashCache
+    {
+        public const int FormatVersion = 1;
+
+        private readonly ConcurrentDictionary<string, Lazy<CxHashNode>> _trees = new ConcurrentDictionary<string, Lazy<CxHashNode>>();
+        private readonly string _directory;
+        private long _hits = 0;
+        private long _misses = 0;
+        private long _diskHits = 0;
+
+        public bool PublicOnly { get; }
+        public long Hits => Interlocked.Read(ref _hits);
+        public long Misses => Interlocked.Read(ref _misses);
+        public long DiskHits => Interlocked.Read(ref _diskHits);
+
+        public CxHashCache(bool publicOnly = true, string directory = null)
+        {
+            PublicOnly = publicOnly;
+            _directory = directory;
+            if (_directory != null)
+            {
+                Directory.CreateDirectory(_directory);
+            }
+        }
+
+        public CxHashNode GetOrHash(string path, Func<CxSourceText, CxNamespace> analyze)
+        {
+            var content = File.ReadAllBytes(path);
+            var hash = HeaderModelCache.ComputeHash(content);
+
+            var analyzed = false;
+            var entry = _trees.GetOrAdd(hash, key => new Lazy<CxHashNode>(() =>
+            {
+                var res = LoadOrHash(key, path, content, analyze, out var fromDisk);
+                analyzed = !fromDisk;
+                return res;
+            }));
+
+            CxHashNode tree;
+            try
+            {
+                tree = entry.Value;
+            }
+            catch
+            {
+                // A Lazy keeps the exception, so it is evicted to retry next time.
+                _trees.TryRemove(new KeyValuePair<string, Lazy<CxHashNode>>(hash, entry));
+                throw;
+            }
+
+            if (!analyzed) Interlocked.Increment(ref _hits);
+            return tree;
+        }
+
+        private CxHashNode LoadOrHash(string hash, string path, byte[] content, Func<CxSourceText, CxNamespace> analyze, out bool fromDisk)
+        {
+            fromDisk = false;
+            var cacheFile = _directory == null ? null : Path.Combine(_directory, $"{hash}.{(PublicOnly ? "api" : "all")}.v{FormatVersion}.json");
+            if (cacheFile != null && File.Exists(cacheFile))
+            {
+                try
+                {
+                    var stored = JsonSerializer.Deserialize<CxHashNode>(File.ReadAllBytes(cacheFile));
+                    if (stored != null)
+                    {
+                        Interlocked.Increment(ref _diskHits);
+                        fromDisk = true;
+                        return stored;
+                    }
+                }
+                catch (JsonException)
+                {
+                    // A corrupt or partially written entry is simply rebuilt.
+                }
+            }
+
+            Interlocked.Increment(ref _misses);
+
+            string text;
+            using (var reader = new StreamReader(new MemoryStream(content), Encoding.UTF8, detectEncodingFromByteOrderMarks: true))
+            {
+                text = reader.ReadToEnd();
+            }
+            var tree = new CxModelHasher { PublicOnly = PublicOnly }.Hash(analyze(new CxSourceText(text, path)));
+
+            if (cacheFile != null)
+            {
+                var tmpFile = $"{cacheFile}.{Guid.NewGuid():N}.tmp";
+                File.WriteAllBytes(tmpFile, JsonSerializer.SerializeToUtf8Bytes(tree));
+                File.Move(tmpFile, cacheFile, overwrite: true);
+            }
+
+            return tree;
+        }
+    }
+}
@@ -0,0 +1,29 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Diffing
+{
+    public enum CxHashNodeKind
+    {
+        Namespace, Class, Function, Variable, Field
+    }
+
+    public sealed class CxHashNode
+    {
+        public CxHashNodeKind Kind { get; init; }
+        public string Name { get; init; }
+        // Identifies the node among its siblings; functions add their parameter types, so
+        // overloads are told apart.
+        public string Key { get; init; }
+        // The node's own declaration, without its children.
+        public CxHash OwnHash { get; init; }
+        // OwnHash rolled up with the hashes of all children.
+        public CxHash Hash { get; init; }
+        public List<CxHashNode> Children { get; init; } = new List<CxHashNode>();
+
+        public override string ToString() => $"{Kind} {Key} {Hash}";
+    }
+}
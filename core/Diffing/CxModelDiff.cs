@@ -0,0 +1,69 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Diffing
+{
+    public enum CxChangeKind
+    {
+        Added, Removed, Changed
+    }
+
+    public record CxModelChange(CxChangeKind Kind, string Path, CxHashNode Before, CxHashNode After)
+    {
+        public override string ToString() => $"{Kind switch { CxChangeKind.Added => '+', CxChangeKind.Removed => '-', _ => '~' }} {(After ?? Before).Kind} {Path}";
+    }
+
+    // Compares two hash trees. Subtrees with equal hashes are skipped without being visited,
+    // so the cost depends on the number of changed declarations, not on the model size.
+    public static class CxModelDiff
+    {
+        public static List<CxModelChange> Compare(CxHashNode before, CxHashNode after)
+        {
+            var res = new List<CxModelChange>();
+            Compare(before, after, string.Empty, res);
+            return res;
+        }
+
+        private static void Compare(CxHashNode before, CxHashNode after, string path, List<CxModelChange> changes)
+        {
+            if (before.Hash == after.Hash) return;
+
+            // Namespaces have no declaration of their own to change.
+            if (before.OwnHash != after.OwnHash && before.Kind != CxHashNodeKind.Namespace)
+            {
+                changes.Add(new CxModelChange(CxChangeKind.Changed, path, before, after));
+            }
+
+            // Siblings can share a key, e.g. a function declared twice; those are paired in order.
+            var remaining = before.Children
+                .GroupBy(o => (o.Kind, o.Key))
+                .ToDictionary(o => o.Key, o => new Queue<CxHashNode>(o));
+
+            foreach (var child in after.Children)
+            {
+                var childPath = Combine(path, child.Key);
+                if (remaining.TryGetValue((child.Kind, child.Key), out var candidates) && candidates.Count > 0)
+                {
+                    Compare(candidates.Dequeue(), child, childPath, changes);
+                }
+                else
+                {
+                    changes.Add(new CxModelChange(CxChangeKind.Added, childPath, null, child));
+                }
+            }
+
+            foreach (var child in remaining.Values.SelectMany(o => o))
+            {
+                changes.Add(new CxModelChange(CxChangeKind.Removed, Combine(path, child.Key), child, null));
+            }
+        }
+
+        private static string Combine(string path, string key)
+        {
+            return path.Length == 0 ? key : $"{path}::{key}";
+        }
+    }
+}
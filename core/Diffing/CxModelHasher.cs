@@ -0,0 +1,205 @@
+﻿using cppcx.Core.Models;
+using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Diffing
+{
+    // Computes structural hashes of a model, Merkle-style: a node's hash covers its own
+    // declaration and the hashes of its children, so two equal hashes mean equal subtrees.
+    // Children are hashed in sorted order, so moving declarations around changes nothing.
+    //
+    // Only declarations are hashed; spans and function bodies are not. Type and value text
+    // is normalized to single spaces between identifiers, so formatting doesn't count either.
+    public class CxModelHasher
+    {
+        private readonly ArrayBufferWriter<byte> _buffer = new ArrayBufferWriter<byte>(256);
+        private readonly StringBuilder _sb = new StringBuilder();
+
+        // Leaves out private and internal members, static namespace functions and parameter
+        // names, which are not part of the API surface. Out-of-line definitions such as
+        // `App::OnLaunched` are left out too: they carry no visibility, and the API is their
+        // declaration in the class.
+        public bool PublicOnly { get; init; } = true;
+
+        public CxHashNode Hash(CxNamespace root)
+        {
+            return HashNamespace(root);
+        }
+
+        private CxHashNode HashNamespace(CxNamespace ns)
+        {
+            var children = new List<CxHashNode>();
+            children.AddRange(ns.NestedNamespaces.Select(HashNamespace));
+            children.AddRange(ns.Classes.Select(HashClass));
+            children.AddRange(ns.Functions.Where(o => !PublicOnly || (!o.IsStatic && !IsQualified(o.Name))).Select(o => HashFunction(o, null)));
+            children.AddRange(ns.GlobalVariables.Where(o => !PublicOnly || !IsQualified(o.TypedName?.Name)).Select(HashVariable));
+
+            Begin(CxHashNodeKind.Namespace);
+            Write(ns.Namespace);
+            return Create(CxHashNodeKind.Namespace, ns.Namespace, ns.Namespace, children);
+        }
+
+        private CxHashNode HashClass(CxClass cls)
+        {
+            var children = new List<CxHashNode>();
+            children.AddRange(cls.NestedClasses.Select(HashClass));
+            children.AddRange(cls.Functions.Where(o => IsVisible(o.Visibility)).Select(o => HashFunction(o.Function, o)));
+            children.AddRange(cls.Fields.Where(o => IsVisible(o.Visibility)).Select(HashField));
+
+            Begin(CxHashNodeKind.Class);
+            Write(cls.Name);
+            Write(cls.IsSealed);
+            Write(cls.IsFinal);
+            return Create(CxHashNodeKind.Class, cls.Name, cls.Name, children);
+        }
+
+        private CxHashNode HashFunction(CxFunction function, CxMemberFunction member)
+        {
+            var parameterTypes = function.Parameters.Select(o => Normalize(o.TypedName?.Type?.Name)).ToList();
+
+            Begin(CxHashNodeKind.Function);
+            Write(function.Name);
+            Write(Normalize(function.ReturnType?.Name));
+            Write(function.IsStatic);
+            for (int i = 0; i < function.Parameters.Count; ++i)
+            {
+                Write(parameterTypes[i]);
+                Write(PublicOnly ? null : function.Parameters[i].TypedName?.Name);
+                Write(Normalize(function.Parameters[i].DefaultValue));
+            }
+            if (member != null)
+            {
+                Write((int)member.Visibility);
+                Write(member.IsVirtual);
+                Write(member.IsOverriden);
+            }
+
+            return Create(CxHashNodeKind.Function, function.Name, $"{function.Name}({string.Join(", ", parameterTypes)})", null);
+        }
+
+        private CxHashNode HashVariable(CxGlobalVariable variable)
+        {
+            var name = variable.TypedName?.Name;
+
+            Begin(CxHashNodeKind.Variable);
+            Write(name);
+            Write(Normalize(variable.TypedName?.Type?.Name));
+            Write(Normalize(variable.InitValue));
+            Write(variable.IsExtern);
+            return Create(CxHashNodeKind.Variable, name, name, null);
+        }
+
+        private CxHashNode HashField(CxField field)
+        {
+            var name = field.TypedName?.Name;
+
+            Begin(CxHashNodeKind.Field);
+            Write(name);
+            Write(Normalize(field.TypedName?.Type?.Name));
+            Write(Normalize(field.InitValue));
+            Write((int)field.Visibility);
+            Write(field.IsStatic);
+            return Create(CxHashNodeKind.Field, name, name, null);
+        }
+
+        private static bool IsQualified(string name)
+        {
+            return name != null && name.Contains("::");
+        }
+
+        private bool IsVisible(CxVisibility visibility)
+        {
+            return !PublicOnly || visibility == CxVisibility.Public || visibility == CxVisibility.Protected;
+        }
+
+        // Hashes the buffered declaration, then rolls the children up into the node hash.
+        private CxHashNode Create(CxHashNodeKind kind, string name, string key, List<CxHashNode> children)
+        {
+            var own = CxHash.Compute(_buffer.WrittenSpan);
+            var hash = own;
+
+            if (children != null && children.Count > 0)
+            {
+                _buffer.Clear();
+                own.WriteTo(_buffer.GetSpan(16));
+                _buffer.Advance(16);
+                foreach (var child in children.Select(o => o.Hash).OrderBy(o => o))
+                {
+                    child.WriteTo(_buffer.GetSpan(16));
+                    _buffer.Advance(16);
+                }
+                hash = CxHash.Compute(_buffer.WrittenSpan);
+            }
+
+            return new CxHashNode
+            {
+                Kind = kind,
+                Name = name ?? string.Empty,
+                Key = key ?? string.Empty,
+                OwnHash = own,
+                Hash = hash,
+                Children = children ?? new List<CxHashNode>(),
+            };
+        }
+
+        private void Begin(CxHashNodeKind kind)
+        {
+            _buffer.Clear();
+            Write((int)kind);
+        }
+
+        private void Write(bool value)
+        {
+            Write(value ? 1 : 0);
+        }
+
+        private void Write(int value)
+        {
+            _buffer.GetSpan(1)[0] = (byte)value;
+            _buffer.Advance(1);
+        }
+
+        // Length-prefixed, so adjacent strings can't run into each other; -1 for null.
+        private void Write(string value)
+        {
+            var length = value == null ? -1 : Encoding.UTF8.GetByteCount(value);
+            BitConverter.TryWriteBytes(_buffer.GetSpan(4), length);
+            _buffer.Advance(4);
+
+            if (length > 0)
+            {
+                _buffer.Advance(Encoding.UTF8.GetBytes(value, _buffer.GetSpan(length)));
+            }
+        }
+
+        // `Platform::String ^  s` and `Platform::String^ s` are the same tokens; whitespace only
+        // matters between two identifier characters.
+        private string Normalize(string text)
+        {
+            if (text == null) return null;
+
+            _sb.Clear();
+            var pendingSpace = false;
+            foreach (var c in text)
+            {
+                if (char.IsWhiteSpace(c))
+                {
+                    pendingSpace = _sb.Length > 0;
+                    continue;
+                }
+
+                if (pendingSpace && IsIdentifierChar(_sb[^1]) && IsIdentifierChar(c)) _sb.Append(' ');
+                pendingSpace = false;
+                _sb.Append(c);
+            }
+
+            return _sb.ToString();
+        }
+
+        private static bool IsIdentifierChar(char c) => char.IsLetterOrDigit(c) || c == '_';
+    }
+}
@@ -1,22 +1,77 @@
 ﻿using Antlr4.Runtime;
 using Antlr4.Runtime.Misc;
 using Antlr4.Runtime.Tree;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
+using System.IO;
 using System.Text;
 
 namespace cppcx.Core.Helpers
 {
+    public enum CPPCXPrinterText
+    {
+        None,
+        // Token index range and the position of the first token.
+        Tokens,
+        // The start of the rule's source text, cut at MaxTextLength.
+        Truncated,
+        // GetText() of the whole subtree; quadratic in the tree depth, only for small trees.
+        Full
+    }
+
+    // Writes one line per rule straight to a TextWriter, so trees of large files can be dumped
+    // without holding the output in memory. Use it as a listener, or call Print, which also
+    // skips the subtrees below MaxDepth.
     public class CPPCXPrinter : IParseTreeListener
     {
+        private readonly TextWriter _writer;
+        private readonly StringWriter _content;
+        private char[] _indent = new char[64];
+        private char[] _text = Array.Empty<char>();
         private int _level = 0;
-        private readonly StringBuilder _sb = new StringBuilder();
 
-        public string Content => _sb.ToString();
+        public CPPCXPrinterText Text { get; init; } = CPPCXPrinterText.Truncated;
+        public int MaxTextLength { get; init; } = 80;
+        public int MaxDepth { get; init; } = int.MaxValue;
+        // Rule indexes to print, all when null. Filtered rules still count for the indentation.
+        public ISet<int> Rules { get; init; } = null;
+
+        public string Content => _content?.ToString() ?? throw new InvalidOperationException("The printer writes to a TextWriter");
+
+        public CPPCXPrinter()
+            : this(new StringWriter())
+        {
+            _content = (StringWriter)_writer;
+        }
+
+        public CPPCXPrinter(TextWriter writer)
+        {
+            _writer = writer ?? throw new ArgumentNullException(nameof(writer));
+            Array.Fill(_indent, ' ');
+        }
+
+        public void Print(IParseTree tree)
+        {
+            if (tree is not ParserRuleContext ctx) return;
+
+            EnterEveryRule(ctx);
+            if (_level < MaxDepth)
+            {
+                for (int i = 0; i < ctx.ChildCount; ++i)
+                {
+                    Print(ctx.GetChild(i));
+                }
+            }
+            ExitEveryRule(ctx);
+        }
 
         public void EnterEveryRule(ParserRuleContext ctx)
         {
-            _sb.AppendLine($"{new string(' ', _level * 2)} {ctx.GetType().Name} {ctx.GetText()}");
+            if (_level < MaxDepth && (Rules == null || Rules.Contains(ctx.RuleIndex)))
+            {
+                WriteRule(ctx);
+            }
             ++_level;
         }
 
@@ -32,5 +87,75 @@ namespace cppcx.Core.Helpers
         public void VisitTerminal(ITerminalNode node)
         {
         }
+
+        private void WriteRule(ParserRuleContext ctx)
+        {
+            if (_indent.Length < _level * 2)
+            {
+                _indent = new char[_level * 4];
+                Array.Fill(_indent, ' ');
+            }
+
+            _writer.Write(_indent, 0, _level * 2);
+            _writer.Write(' ');
+            _writer.Write(ctx.GetType().Name);
+
+            switch (Text)
+            {
+                case CPPCXPrinterText.Tokens:
+                    if (ctx.Start != null)
+                    {
+                        _writer.Write($" [{ctx.Start.TokenIndex}..{(ctx.Stop ?? ctx.Start).TokenIndex}] {ctx.Start.Line}:{ctx.Start.Column}");
+                    }
+                    break;
+                case CPPCXPrinterText.Truncated:
+                    WriteTruncated(ctx);
+                    break;
+                case CPPCXPrinterText.Full:
+                    _writer.Write(' ');
+                    _writer.Write(ctx.GetText());
+                    break;
+            }
+
+            _writer.WriteLine();
+        }
+
+        private void WriteTruncated(ParserRuleContext ctx)
+        {
+            var input = ctx.Start?.InputStream;
+            ReadOnlySpan<char> text;
+            bool truncated;
+            if (input == null)
+            {
+                // Tokens created without a char stream only carry their own text.
+                var full = ctx.GetText();
+                if (full.Length == 0) return;
+
+                text = full.AsSpan(0, Math.Min(full.Length, MaxTextLength));
+                truncated = text.Length < full.Length;
+            }
+            else
+            {
+                var span = CxSourceSpan.Of(ctx);
+                if (span.IsEmpty) return;
+
+                var length = Math.Min(span.Length, MaxTextLength);
+                text = input is CxSourceText source
+                    ? source.Slice(new CxSourceSpan(span.Start, length))
+                    : input.GetText(Interval.Of(span.Start, span.Start + length - 1)).AsSpan();
+                truncated = length < span.Length;
+            }
+
+            if (_text.Length < text.Length) _text = new char[MaxTextLength];
+            for (int i = 0; i < text.Length; ++i)
+            {
+                var c = text[i];
+                _text[i] = c == '\r' || c == '\n' || c == '\t' ? ' ' : c;
+            }
+
+            _writer.Write(' ');
+            _writer.Write(_text, 0, text.Length);
+            if (truncated) _writer.Write("...");
+        }
     }
 }
@@ -0,0 +1,53 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Tree;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Helpers
+{
+    // Like ParseTreeWalker, but does not descend into function bodies and initializers,
+    // which hold most of the nodes and none of the declarations we are interested in.
+    public class DeclarationTreeWalker
+    {
+        public static readonly DeclarationTreeWalker Default = new DeclarationTreeWalker();
+
+        public void Walk(IParseTreeListener listener, IParseTree tree)
+        {
+            switch (tree)
+            {
+                case IErrorNode errorNode:
+                    listener.VisitErrorNode(errorNode);
+                    return;
+                case ITerminalNode terminalNode:
+                    listener.VisitTerminal(terminalNode);
+                    return;
+            }
+
+            var ctx = (ParserRuleContext)tree;
+            listener.EnterEveryRule(ctx);
+            ctx.EnterRule(listener);
+
+            if (!IsOpaque(ctx))
+            {
+                for (int i = 0; i < ctx.ChildCount; ++i)
+                {
+                    Walk(listener, ctx.GetChild(i));
+                }
+            }
+
+            ctx.ExitRule(listener);
+            listener.ExitEveryRule(ctx);
+        }
+
+        protected virtual bool IsOpaque(ParserRuleContext ctx)
+        {
+            return ctx is CPPCXParser.FunctionBodyContext
+                || ctx is CPPCXParser.InitializerContext
+                || ctx is CPPCXParser.BraceOrEqualInitializerContext
+                || ctx is CPPCXParser.InitializerClauseContext;
+        }
+    }
+}
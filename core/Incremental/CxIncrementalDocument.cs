@@ -0,0 +1,291 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Atn;
+using Antlr4.Runtime.Misc;
+using Antlr4.Runtime.Tree;
+using cppcx.Core.Analyzers;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Incremental
+{
+    // Keeps the tree and analysis of a file up to date while it is edited. An edit inside a
+    // single declaration only re-lexes and re-parses that declaration and splices it into the
+    // tree, the token list and the namespace bodies; anything else falls back to a full parse.
+    public class CxIncrementalDocument
+    {
+        public class EditResult
+        {
+            public bool IsIncremental { get; init; }
+            public CPPCXParser.DeclarationContext Declaration { get; init; }
+            public TimeSpan Elapsed { get; init; }
+        }
+
+        private readonly CxParserWorker _worker;
+        private CPPCXLexer _lexer;
+        private CPPCXParser _parser;
+        private int _generation = -1;
+        private readonly SyntaxErrorCollector _errors = new SyntaxErrorCollector();
+        private List<IToken> _tokens;
+
+        public CxSourceText Source { get; private set; }
+        public CPPCXParser.TranslationUnitContext TranslationUnit { get; private set; }
+        public TranslationUnitAnalyzer.TranslationUnit Analysis { get; private set; }
+        public List<CxSyntaxError> SyntaxErrors { get; private set; }
+        public IReadOnlyList<IToken> Tokens => _tokens;
+        public string Text => Source.ToString();
+
+        public CxIncrementalDocument(string text, string sourceName = null, CxPredictionStrategy predictionStrategy = CxPredictionStrategy.TwoStage)
+        {
+            // Function bodies are always parsed, since edits mostly happen inside them.
+            _worker = new CxParserWorker(new CxParseOptions { PredictionStrategy = predictionStrategy });
+
+            CreateRecognizers();
+            ParseAll(new CxSourceText(text, sourceName));
+        }
+
+        // Like CxParserWorker, the recognizers are created again once the DFA cache has been
+        // replaced, so they don't keep the old prediction contexts alive.
+        private void CreateRecognizers()
+        {
+            if (_generation == CxDfaCache.Generation) return;
+            _generation = CxDfaCache.Generation;
+
+            _lexer = new CPPCXLexer(null);
+            _lexer.RemoveErrorListeners();
+            _lexer.AddErrorListener(_errors);
+
+            _parser = new CPPCXParser(null);
+            _parser.RemoveErrorListeners();
+            _parser.AddErrorListener(_errors);
+        }
+
+        public static CxIncrementalDocument FromFile(string filename)
+        {
+            return new CxIncrementalDocument(File.ReadAllText(filename), filename);
+        }
+
+        public EditResult Apply(CxTextEdit edit)
+        {
+            if (edit.Start < 0 || edit.Length < 0 || edit.End > Source.Size)
+                throw new ArgumentOutOfRangeException(nameof(edit));
+
+            var sw = Stopwatch.StartNew();
+
+            var declaration = FindDeclaration(TranslationUnit.declarationseq(), edit);
+            if (declaration != null && !HasErrors(declaration))
+            {
+                Source.Replace(edit.Start, edit.Length, edit.NewText ?? string.Empty);
+
+                var reparsed = CxDfaCache.Read(() => Reparse(declaration, edit));
+                if (reparsed != null)
+                {
+                    Splice(declaration, reparsed, edit);
+                    return new EditResult { IsIncremental = true, Declaration = reparsed, Elapsed = sw.Elapsed };
+                }
+
+                ParseAll(new CxSourceText(Source.ToString(), Source.SourceName));
+            }
+            else
+            {
+                var text = Source.ToString();
+                ParseAll(new CxSourceText(string.Concat(text.AsSpan(0, edit.Start), edit.NewText.AsSpan(), text.AsSpan(edit.End)), Source.SourceName));
+            }
+
+            return new EditResult { IsIncremental = false, Elapsed = sw.Elapsed };
+        }
+
+        private void ParseAll(CxSourceText source)
+        {
+            var parsed = _worker.Parse(source);
+            var tokens = (BufferedTokenStream)parsed.Tokens;
+            tokens.Fill();
+
+            Source = source;
+            TranslationUnit = parsed.TranslationUnit;
+            SyntaxErrors = parsed.SyntaxErrors;
+            Analysis = new TranslationUnitAnalyzer().Visit(parsed.TranslationUnit);
+            _tokens = tokens.GetTokens().ToList();
+        }
+
+        // The innermost declaration that the edit lies strictly inside of. Its first and last
+        // chars are kept, so the tokens around it can not be merged with the edited ones.
+        private static CPPCXParser.DeclarationContext FindDeclaration(CPPCXParser.DeclarationseqContext seq, CxTextEdit edit)
+        {
+            while (seq != null)
+            {
+                var declaration = seq.declaration().FirstOrDefault(o => o.Start.StartIndex < edit.Start && edit.End <= o.Stop.StopIndex);
+                if (declaration == null) return null;
+
+                var ns = declaration.namespaceDefinition();
+                if (ns == null) return declaration;
+
+                // Edits to the namespace head or braces change the namespace structure.
+                seq = ns.namespaceBody;
+            }
+
+            return null;
+        }
+
+        private static bool HasErrors(IParseTree tree)
+        {
+            if (tree is IErrorNode) return true;
+            if (tree is ParserRuleContext ctx && ctx.exception != null) return true;
+
+            for (int i = 0; i < tree.ChildCount; ++i)
+            {
+                if (HasErrors(tree.GetChild(i))) return true;
+            }
+
+            return false;
+        }
+
+        private CPPCXParser.DeclarationContext Reparse(CPPCXParser.DeclarationContext declaration, CxTextEdit edit)
+        {
+            var start = declaration.Start;
+            var span = new CxSourceSpan(start.StartIndex, declaration.Stop.StopIndex + 1 - start.StartIndex + edit.Delta);
+
+            CreateRecognizers();
+            _errors.Clear();
+            var tokens = CxSpanParser.Lex(_lexer, Source, span, start.Line, start.Column);
+            if (_errors.Errors.Count > 0 || tokens.Count == 0 || tokens[^1].StopIndex != span.End - 1) return null;
+
+            var stream = new CommonTokenStream(new ListTokenSource(tokens, Source.SourceName));
+            _parser.TokenStream = stream;
+            _parser.ErrorHandler = new BailErrorStrategy();
+
+            CPPCXParser.DeclarationContext res;
+            try
+            {
+                _parser.Interpreter.PredictionMode = PredictionMode.SLL;
+                res = _parser.declaration();
+            }
+            catch (ParseCanceledException)
+            {
+                try
+                {
+                    stream.Seek(0);
+                    _parser.TokenStream = stream;
+                    _parser.Interpreter.PredictionMode = PredictionMode.LL;
+                    res = _parser.declaration();
+                }
+                catch (ParseCanceledException)
+                {
+                    return null;
+                }
+            }
+
+            // The region has to parse as exactly one declaration, and not one that changes the
+            // namespace structure.
+            if (stream.LA(1) != TokenConstants.EOF || res.namespaceDefinition() != null) return null;
+            return res;
+        }
+
+        private void Splice(CPPCXParser.DeclarationContext oldDeclaration, CPPCXParser.DeclarationContext newDeclaration, CxTextEdit edit)
+        {
+            var oldStart = oldDeclaration.Start;
+            var oldStop = oldDeclaration.Stop;
+            var newStop = newDeclaration.Stop;
+
+            // Tokens: replace the declaration's range and shift everything after it.
+            var newTokens = ((BufferedTokenStream)_parser.TokenStream).GetTokens()
+                .Where(o => o.Type != TokenConstants.EOF)
+                .ToList();
+            _tokens.RemoveRange(oldStart.TokenIndex, oldStop.TokenIndex - oldStart.TokenIndex + 1);
+            _tokens.InsertRange(oldStart.TokenIndex, newTokens);
+
+            var lineDelta = newStop.Line - oldStop.Line;
+            var columnDelta = newStop.Column - oldStop.Column;
+            for (int i = oldStart.TokenIndex; i < _tokens.Count; ++i)
+            {
+                var token = (CommonToken)_tokens[i];
+                if (i >= oldStart.TokenIndex + newTokens.Count)
+                {
+                    if (token.Line == oldStop.Line) token.Column += columnDelta;
+                    token.Line += lineDelta;
+                    token.StartIndex += edit.Delta;
+                    token.StopIndex += edit.Delta;
+                }
+                token.TokenIndex = i;
+            }
+
+            // Errors: the reparsed region has none, since any would have made it fall back.
+            SyntaxErrors = SyntaxErrors
+                .Where(o => !IsWithin(o, oldStart, oldStop))
+                .Select(o => IsBefore(oldStop, o) ? ShiftError(o, oldStop.Line, lineDelta, columnDelta) : o)
+                .ToList();
+
+            // Tree: swap the subtree, and fix ancestors that started or stopped at its tokens.
+            var seq = (CPPCXParser.DeclarationseqContext)oldDeclaration.Parent;
+            seq.children[seq.children.IndexOf(oldDeclaration)] = newDeclaration;
+            newDeclaration.Parent = seq;
+            newDeclaration.invokingState = oldDeclaration.invokingState;
+
+            for (var ctx = (ParserRuleContext)seq; ctx != null; ctx = ctx.Parent as ParserRuleContext)
+            {
+                if (ctx.Start == oldStart) ctx.Start = newDeclaration.Start;
+                if (ctx.Stop == oldStop) ctx.Stop = newStop;
+            }
+
+            // Analysis: replace the entries that came from the old declaration.
+            var body = seq.Parent is CPPCXParser.TranslationUnitContext
+                ? Analysis.Bodies.FirstOrDefault(o => ReferenceEquals(o.Namespace, Analysis.Root)).Body
+                : Analysis.Bodies.FirstOrDefault(o => o.Namespace.Contexts.Contains(seq)).Body;
+            if (body == null) return;
+
+            var added = newDeclaration.Accept(new NamespaceBodyAnalyzer()) ?? new NamespaceBodyAnalyzer.NamespaceBody();
+            var position = newDeclaration.Start.StartIndex;
+            SpliceEntries(body.GlobalVariables, added.GlobalVariables, o => o.Context, oldDeclaration, position);
+            SpliceEntries(body.Classes, added.Classes, o => o.Context, oldDeclaration, position);
+            SpliceEntries(body.FunctionDeclarations, added.FunctionDeclarations, o => o.Context, oldDeclaration, position);
+            SpliceEntries(body.FunctionDefinitions, added.FunctionDefinitions, o => o.Context, oldDeclaration, position);
+        }
+
+        private static void SpliceEntries<T>(List<T> entries, List<T> added, Func<T, ParserRuleContext> getContext, RuleContext oldDeclaration, int position)
+        {
+            entries.RemoveAll(o => IsWithin(getContext(o), oldDeclaration));
+
+            var index = entries.FindIndex(o => getContext(o).Start.StartIndex > position);
+            entries.InsertRange(index < 0 ? entries.Count : index, added);
+        }
+
+        private static bool IsWithin(CxSyntaxError error, IToken start, IToken stop)
+        {
+            return !IsBefore(error, start) && !IsBefore(stop, error);
+        }
+
+        private static bool IsBefore(CxSyntaxError error, IToken token)
+        {
+            return error.Line < token.Line || error.Line == token.Line && error.Column < token.Column;
+        }
+
+        private static bool IsBefore(IToken token, CxSyntaxError error)
+        {
+            return token.Line < error.Line || token.Line == error.Line && token.Column < error.Column;
+        }
+
+        private static CxSyntaxError ShiftError(CxSyntaxError error, int line, int lineDelta, int columnDelta)
+        {
+            return error with
+            {
+                Line = error.Line + lineDelta,
+                Column = error.Line == line ? error.Column + columnDelta : error.Column,
+            };
+        }
+
+        private static bool IsWithin(RuleContext ctx, RuleContext ancestor)
+        {
+            for (; ctx != null; ctx = ctx.Parent)
+            {
+                if (ctx == ancestor) return true;
+            }
+
+            return false;
+        }
+    }
+}
@@ -0,0 +1,15 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Incremental
+{
+    // Replaces Length chars at Start with NewText. Offsets are relative to the text before the edit.
+    public record CxTextEdit(int Start, int Length, string NewText)
+    {
+        public int End => Start + Length;
+        public int Delta => (NewText?.Length ?? 0) - Length;
+    }
+}
@@ -0,0 +1,436 @@
+﻿using Antlr4.Runtime;
+using cppcx.Core.Parsing;
+using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Indexing
+{
+    public record CxIdentifierOccurrence(string Path, CxSourceSpan Span)
+    {
+        public override string ToString() => $"{Path}{Span}";
+    }
+
+    // Maps identifier tokens to the files and offsets they occur at. Files are only lexed, which
+    // is much cheaper than parsing them, so the index is meant to narrow a search down to the
+    // few files worth parsing, e.g. every file that mentions `App`.
+    //
+    // A posting holds the offsets of one identifier in one file as delta-encoded varints.
+    // Postings of an identifier are sorted by file id, so candidates of several identifiers
+    // are found with a merge rather than with hash sets.
+    public class CxIdentifierIndex
+    {
+        private const string Magic = "CXIDS";
+        private const int Version = 1;
+
+        private readonly struct Posting
+        {
+            public readonly int File;
+            public readonly byte[] Offsets;
+
+            public Posting(int file, byte[] offsets)
+            {
+                File = file;
+                Offsets = offsets;
+            }
+        }
+
+        private class Term
+        {
+            public string Name;
+            public List<Posting> Postings = new List<Posting>(1);
+        }
+
+        private class FileEntry
+        {
+            public int Id;
+            public string Path;
+            public long Length;
+            public long LastWriteTicks;
+            public List<Term> Terms = new List<Term>();
+        }
+
+        private readonly object _lock = new object();
+        private readonly NameTable _names = new NameTable();
+        private readonly Dictionary<string, Term> _terms = new Dictionary<string, Term>(StringComparer.Ordinal);
+        private readonly Dictionary<string, FileEntry> _files = new Dictionary<string, FileEntry>(StringComparer.Ordinal);
+        private readonly Dictionary<int, FileEntry> _filesById = new Dictionary<int, FileEntry>();
+        // Ids are never reused, so an updated file is appended to every posting list it is in.
+        private int _nextFileId = 0;
+
+        public int Count
+        {
+            get
+            {
+                lock (_lock) return _terms.Count;
+            }
+        }
+
+        public IReadOnlyList<string> Files
+        {
+            get
+            {
+                lock (_lock) return _files.Keys.ToList();
+            }
+        }
+
+        // Lets a rebuild skip files that haven't been touched since they were lexed.
+        public bool IsUpToDate(string path)
+        {
+            var file = new FileInfo(path);
+            lock (_lock)
+            {
+                return _files.TryGetValue(file.FullName, out var entry)
+                    && IndexFiles.IsUnchanged(file, entry.Length, entry.LastWriteTicks);
+            }
+        }
+
+        public void Update(string path)
+        {
+            Update(path, CxSourceText.FromFile(path));
+        }
+
+        // Replaces everything the file contributed. The input is lexed outside of the lock, so
+        // several files can be updated in parallel.
+        public void Update(string path, ICharStream input)
+        {
+            var file = new FileInfo(path);
+            var (length, lastWriteTicks) = IndexFiles.GetStamp(file);
+            var postings = Encode(Lex(input));
+
+            lock (_lock)
+            {
+                RemoveLocked(file.FullName);
+
+                var entry = new FileEntry
+                {
+                    Id = _nextFileId++,
+                    Path = file.FullName,
+                    Length = length,
+                    LastWriteTicks = lastWriteTicks,
+                };
+                _files.Add(entry.Path, entry);
+                _filesById.Add(entry.Id, entry);
+
+                foreach (var (name, offsets) in postings)
+                {
+                    var term = GetOrAddTerm(name);
+                    term.Postings.Add(new Posting(entry.Id, offsets));
+                    entry.Terms.Add(term);
+                }
+            }
+        }
+
+        public bool Remove(string path)
+        {
+            lock (_lock)
+            {
+                return RemoveLocked(Path.GetFullPath(path));
+            }
+        }
+
+        // Files that contain every part of a name like `ApplicationResourceKeys::h`. Since only
+        // tokens are indexed, this is a superset of the files that use the name.
+        public IReadOnlyList<string> FindFiles(string name)
+        {
+            lock (_lock)
+            {
+                return FindFileIds(name).Select(o => _filesById[o].Path).ToList();
+            }
+        }
+
+        // Occurrences of the last part of the name, in the files that contain all of its parts.
+        public IReadOnlyList<CxIdentifierOccurrence> Find(string name)
+        {
+            var res = new List<CxIdentifierOccurrence>();
+            var parts = IndexFiles.SplitName(name);
+            if (parts.Length == 0) return res;
+
+            lock (_lock)
+            {
+                if (!_terms.TryGetValue(parts[^1], out var term)) return res;
+
+                var files = FindFileIds(name);
+                var i = 0;
+                foreach (var posting in term.Postings)
+                {
+                    while (i < files.Count && files[i] < posting.File) ++i;
+                    if (i == files.Count) break;
+                    if (files[i] != posting.File) continue;
+
+                    var path = _filesById[posting.File].Path;
+                    foreach (var offset in Decode(posting.Offsets))
+                    {
+                        res.Add(new CxIdentifierOccurrence(path, new CxSourceSpan(offset, term.Name.Length)));
+                    }
+                }
+            }
+
+            return res;
+        }
+
+        // Line (1-based) and column (0-based) of each occurrence, reading every file once. The
+        // files are read as they are now, so positions are only right while the index is fresh.
+        public static IEnumerable<(CxIdentifierOccurrence Occurrence, int Line, int Column)> Locate(IEnumerable<CxIdentifierOccurrence> occurrences)
+        {
+            foreach (var group in occurrences.GroupBy(o => o.Path))
+            {
+                var lines = IndexFiles.GetLineStarts(File.Exists(group.Key) ? File.ReadAllText(group.Key) : string.Empty);
+                foreach (var occurrence in group)
+                {
+                    var (line, column) = IndexFiles.GetPosition(lines, occurrence.Span.Start);
+                    yield return (occurrence, line, column);
+                }
+            }
+        }
+
+        public void SaveFile(string filename)
+        {
+            IndexFiles.Save(filename, Save);
+        }
+
+        public static CxIdentifierIndex LoadFile(string filename)
+        {
+            return IndexFiles.Load(filename, Load);
+        }
+
+        // File ids are written as their position in the file table, so they are compacted on load.
+        public void Save(Stream stream)
+        {
+            lock (_lock)
+            {
+                using var writer = new BinaryWriter(stream, Encoding.UTF8, leaveOpen: true);
+                writer.Write(Magic);
+                writer.Write(Version);
+
+                var files = _filesById.Values.OrderBy(o => o.Id).ToList();
+                var positions = new Dictionary<int, int>(files.Count);
+                writer.Write7BitEncodedInt(files.Count);
+                foreach (var file in files)
+                {
+                    positions.Add(file.Id, positions.Count);
+                    writer.Write(file.Path);
+                    writer.Write(file.Length);
+                    writer.Write(file.LastWriteTicks);
+                }
+
+                writer.Write7BitEncodedInt(_terms.Count);
+                foreach (var term in _terms.Values)
+                {
+                    writer.Write(term.Name);
+                    writer.Write7BitEncodedInt(term.Postings.Count);
+
+                    var previous = 0;
+                    foreach (var posting in term.Postings)
+                    {
+                        var position = positions[posting.File];
+                        writer.Write7BitEncodedInt(position - previous);
+                        writer.Write7BitEncodedInt(posting.Offsets.Length);
+                        writer.Write(posting.Offsets);
+                        previous = position;
+                    }
+                }
+            }
+        }
+
+        public static CxIdentifierIndex Load(Stream stream)
+        {
+            using var reader = new BinaryReader(stream, Encoding.UTF8, leaveOpen: true);
+            try
+            {
+                if (reader.ReadString() != Magic || reader.ReadInt32() != Version)
+                    throw new InvalidDataException("Not an identifier index");
+
+                var res = new CxIdentifierIndex();
+                var files = new FileEntry[reader.Read7BitEncodedInt()];
+                for (int i = 0; i < files.Length; ++i)
+                {
+                    files[i] = new FileEntry
+                    {
+                        Id = i,
+                        Path = reader.ReadString(),
+                        Length = reader.ReadInt64(),
+                        LastWriteTicks = reader.ReadInt64(),
+                    };
+                    res._files.Add(files[i].Path, files[i]);
+                    res._filesById.Add(i, files[i]);
+                }
+                res._nextFileId = files.Length;
+
+                for (int count = reader.Read7BitEncodedInt(); count > 0; --count)
+                {
+                    var term = res.GetOrAddTerm(res._names.Get(reader.ReadString().AsSpan()));
+                    var file = 0;
+                    for (int postings = reader.Read7BitEncodedInt(); postings > 0; --postings)
+                    {
+                        file += reader.Read7BitEncodedInt();
+                        var offsets = reader.ReadBytes(reader.Read7BitEncodedInt());
+                        term.Postings.Add(new Posting(file, offsets));
+                        files[file].Terms.Add(term);
+                    }
+                }
+
+                return res;
+            }
+            catch (Exception e) when (e is EndOfStreamException || e is IndexOutOfRangeException || e is ArgumentException || e is FormatException)
+            {
+                throw new InvalidDataException("The identifier index is corrupt", e);
+            }
+        }
+
+        // Collects the offsets of every identifier, in order. Names are interned from the
+        // source span, so an identifier seen before costs no allocation.
+        private Dictionary<string, List<int>> Lex(ICharStream input)
+        {
+            return CxDfaCache.Read(() => LexLocked(input));
+        }
+
+        private Dictionary<string, List<int>> LexLocked(ICharStream input)
+        {
+            var lexer = new CPPCXLexer(input);
+            lexer.RemoveErrorListeners();
+
+            var source = input as CxSourceText;
+            var res = new Dictionary<string, List<int>>(ReferenceEqualityComparer.Instance);
+            for (var token = lexer.NextToken(); token.Type != TokenConstants.EOF; token = lexer.NextToken())
+            {
+                if (token.Type != CPPCXLexer.Identifier) continue;
+
+                var name = source != null ? _names.Get(source.Slice(CxSourceSpan.Of(token))) : _names.Get(token.Text.AsSpan());
+                if (!res.TryGetValue(name, out var offsets))
+                {
+                    offsets = new List<int>();
+                    res.Add(name, offsets);
+                }
+                offsets.Add(token.StartIndex);
+            }
+
+            return res;
+        }
+
+        private static List<(string Name, byte[] Offsets)> Encode(Dictionary<string, List<int>> occurrences)
+        {
+            var res = new List<(string, byte[])>(occurrences.Count);
+            var buffer = new ArrayBufferWriter<byte>(64);
+            foreach (var (name, offsets) in occurrences)
+            {
+                buffer.Clear();
+                var previous = 0;
+                foreach (var offset in offsets)
+                {
+                    WriteVarint(buffer, offset - previous);
+                    previous = offset;
+                }
+                res.Add((name, buffer.WrittenSpan.ToArray()));
+            }
+
+            return res;
+        }
+
+        private static List<int> Decode(byte[] offsets)
+        {
+            var res = new List<int>();
+            var offset = 0;
+            for (int i = 0; i < offsets.Length;)
+            {
+                var delta = 0;
+                for (int shift = 0; ; shift += 7)
+                {
+                    var b = offsets[i++];
+                    delta |= (b & 0x7f) << shift;
+                    if (b < 0x80) break;
+                }
+
+                offset += delta;
+                res.Add(offset);
+            }
+
+            return res;
+        }
+
+        private static void WriteVarint(ArrayBufferWriter<byte> buffer, int value)
+        {
+            var span = buffer.GetSpan(5);
+            var length = 0;
+            var v = (uint)value;
+            for (; v >= 0x80; v >>= 7)
+            {
+                span[length++] = (byte)(v | 0x80);
+            }
+            span[length++] = (byte)v;
+            buffer.Advance(length);
+        }
+
+        // Merges the posting lists of all name parts, starting with the shortest one.
+        private List<int> FindFileIds(string name)
+        {
+            var terms = new List<Term>();
+            foreach (var part in IndexFiles.SplitName(name))
+            {
+                if (!_terms.TryGetValue(part, out var term)) return new List<int>();
+                terms.Add(term);
+            }
+            if (terms.Count == 0) return new List<int>();
+
+            terms.Sort((a, b) => a.Postings.Count.CompareTo(b.Postings.Count));
+            var res = terms[0].Postings.Select(o => o.File).ToList();
+            foreach (var term in terms.Skip(1))
+            {
+                var postings = term.Postings;
+                var kept = 0;
+                for (int i = 0, j = 0; i < res.Count; ++i)
+                {
+                    while (j < postings.Count && postings[j].File < res[i]) ++j;
+                    if (j < postings.Count && postings[j].File == res[i]) res[kept++] = res[i];
+                }
+                res.RemoveRange(kept, res.Count - kept);
+            }
+
+            return res;
+        }
+
+        private bool RemoveLocked(string path)
+        {
+            if (!_files.Remove(path, out var entry)) return false;
+            _filesById.Remove(entry.Id);
+
+            foreach (var term in entry.Terms)
+            {
+                var index = BinarySearch(term.Postings, entry.Id);
+                if (index >= 0) term.Postings.RemoveAt(index);
+                if (term.Postings.Count == 0) _terms.Remove(term.Name);
+            }
+
+            return true;
+        }
+
+        private Term GetOrAddTerm(string name)
+        {
+            if (!_terms.TryGetValue(name, out var term))
+            {
+                term = new Term { Name = name };
+                _terms.Add(name, term);
+            }
+
+            return term;
+        }
+
+        private static int BinarySearch(List<Posting> postings, int file)
+        {
+            int lo = 0, hi = postings.Count - 1;
+            while (lo <= hi)
+            {
+                var mid = lo + (hi - lo) / 2;
+                if (postings[mid].File == file) return mid;
+                if (postings[mid].File < file) lo = mid + 1;
+                else hi = mid - 1;
+            }
+
+            return -1;
+        }
+    }
+}
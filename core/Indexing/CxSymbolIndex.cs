@@ -0,0 +1,594 @@
+﻿using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Indexing
+{
+    // Maps qualified names of namespaces, classes, functions and global variables across files
+    // to their declarations and definitions. Every name part is interned once as a
+    // (parent id, name) pair, so a lookup costs one hash per part, and ids stay stable while
+    // files are updated or removed.
+    //
+    // A member defined outside of its class, like `void App::f() {}`, is indexed under the class
+    // it resolves to, so the declaration and the definition share one id. Resolution depends on
+    // the other indexed files, so it runs again on the first lookup after an update.
+    public class CxSymbolIndex
+    {
+        private const string Magic = "CXIDX";
+        private const int Version = 2;
+        public const int Root = 0;
+
+        private struct Symbol
+        {
+            public int Parent;
+            public string Name;
+            public CxSymbolKind Kind;
+        }
+
+        private class FileEntry
+        {
+            public string Path;
+            public long Length;
+            public long LastWriteTicks;
+            public HashSet<int> Symbols = new HashSet<int>();
+            public List<string[]> Usings = new List<string[]>();
+            public List<OutOfLineMember> OutOfLine = new List<OutOfLineMember>();
+        }
+
+        private class OutOfLineMember
+        {
+            // The namespace the definition appears in, and the class qualifiers as written.
+            public int Scope;
+            public string[] Qualifier;
+            public string Name;
+            public CxSymbolKind Kind;
+            public CxSymbolLocation Location;
+            public int Id = -1;
+        }
+
+        private readonly object _lock = new object();
+        private readonly List<Symbol> _symbols = new List<Symbol>();
+        private readonly Dictionary<(int Parent, string Name), int> _ids = new Dictionary<(int Parent, string Name), int>();
+        private readonly Dictionary<int, List<CxSymbolLocation>> _locations = new Dictionary<int, List<CxSymbolLocation>>();
+        // Index paths are full names from FileInfo; compare them by value everywhere.
+        private static readonly StringComparer PathComparer = StringComparer.Ordinal;
+
+        private readonly Dictionary<string, FileEntry> _files = new Dictionary<string, FileEntry>(PathComparer);
+        private bool _resolved = true;
+
+        public int Count
+        {
+            get
+            {
+                lock (_lock)
+                {
+                    ResolveLocked();
+                    return _symbols.Count;
+                }
+            }
+        }
+
+        public IReadOnlyList<string> Files
+        {
+            get
+            {
+                lock (_lock) return _files.Keys.ToList();
+            }
+        }
+
+        public CxSymbolIndex()
+        {
+            _symbols.Add(new Symbol { Parent = -1, Name = string.Empty, Kind = CxSymbolKind.Namespace });
+        }
+
+        // Returns the id of a name like `Calculator::App::OnLaunched`, or -1.
+        public int Find(string qualifiedName)
+        {
+            lock (_lock)
+            {
+                ResolveLocked();
+                return FindLocked(Root, IndexFiles.SplitName(qualifiedName));
+            }
+        }
+
+        public string GetQualifiedName(int id)
+        {
+            lock (_lock)
+            {
+                ResolveLocked();
+                var parts = new List<string>();
+                for (; id > Root; id = _symbols[id].Parent)
+                {
+                    parts.Add(_symbols[id].Name);
+                }
+
+                parts.Reverse();
+                return string.Join("::", parts);
+            }
+        }
+
+        public CxSymbolKind GetKind(int id)
+        {
+            lock (_lock)
+            {
+                ResolveLocked();
+                return _symbols[id].Kind;
+            }
+        }
+
+        public IReadOnlyList<CxSymbolLocation> GetLocations(int id)
+        {
+            lock (_lock)
+            {
+                ResolveLocked();
+                return _locations.TryGetValue(id, out var locations) ? locations.ToArray() : Array.Empty<CxSymbolLocation>();
+            }
+        }
+
+        public IEnumerable<CxSymbolLocation> GetDeclarations(string qualifiedName)
+        {
+            var id = Find(qualifiedName);
+            return id < 0 ? Enumerable.Empty<CxSymbolLocation>() : GetLocations(id).Where(o => !o.IsDefinition);
+        }
+
+        public IEnumerable<CxSymbolLocation> GetDefinitions(string qualifiedName)
+        {
+            var id = Find(qualifiedName);
+            return id < 0 ? Enumerable.Empty<CxSymbolLocation>() : GetLocations(id).Where(o => o.IsDefinition);
+        }
+
+        // True when the file was indexed and hasn't changed size or write time since.
+        public bool IsUpToDate(string path)
+        {
+            var file = new FileInfo(path);
+            lock (_lock)
+            {
+                return _files.TryGetValue(file.FullName, out var entry)
+                    && IndexFiles.IsUnchanged(file, entry.Length, entry.LastWriteTicks);
+            }
+        }
+
+        // Replaces everything the file contributed. Without the source, locations have no
+        // line and column.
+        public void Update(string path, CxNamespace model, CxSourceText source = null)
+        {
+            var file = new FileInfo(path);
+            var (length, lastWriteTicks) = IndexFiles.GetStamp(file);
+            var lines = source == null ? null : IndexFiles.GetLineStarts(source.Memory.Span);
+
+            lock (_lock)
+            {
+                RemoveLocked(file.FullName);
+
+                var entry = new FileEntry
+                {
+                    Path = file.FullName,
+                    Length = length,
+                    LastWriteTicks = lastWriteTicks,
+                };
+                _files.Add(entry.Path, entry);
+                AddNamespace(entry, model, Root, lines);
+                _resolved = false;
+            }
+        }
+
+        public bool Remove(string path)
+        {
+            lock (_lock)
+            {
+                return RemoveLocked(Path.GetFullPath(path));
+            }
+        }
+
+        public void SaveFile(string filename)
+        {
+            IndexFiles.Save(filename, Save);
+        }
+
+        public static CxSymbolIndex LoadFile(string filename)
+        {
+            return IndexFiles.Load(filename, Load);
+        }
+
+        public void Save(Stream stream)
+        {
+            lock (_lock)
+            {
+                ResolveLocked();
+                using var writer = new BinaryWriter(stream, Encoding.UTF8, leaveOpen: true);
+                writer.Write(Magic);
+                writer.Write(Version);
+
+                var names = new Dictionary<string, int>(StringComparer.Ordinal);
+                foreach (var symbol in _symbols)
+                {
+                    names.TryAdd(symbol.Name, names.Count);
+                }
+                writer.Write7BitEncodedInt(names.Count);
+                foreach (var name in names.Keys)
+                {
+                    writer.Write(name);
+                }
+
+                writer.Write7BitEncodedInt(_symbols.Count - 1);
+                foreach (var symbol in _symbols.Skip(1))
+                {
+                    writer.Write7BitEncodedInt(symbol.Parent);
+                    writer.Write7BitEncodedInt(names[symbol.Name]);
+                    writer.Write((byte)symbol.Kind);
+                }
+
+                // Locations are grouped by file and sorted by offset, so offsets and lines are
+                // stored as small deltas.
+                writer.Write7BitEncodedInt(_files.Count);
+                foreach (var file in _files.Values)
+                {
+                    writer.Write(file.Path);
+                    writer.Write(file.Length);
+                    writer.Write(file.LastWriteTicks);
+
+                    // Out-of-line members are stored unresolved below.
+                    var outOfLine = new HashSet<CxSymbolLocation>(file.OutOfLine.Select(o => o.Location), ReferenceEqualityComparer.Instance);
+                    var locations = file.Symbols
+                        .SelectMany(id => _locations[id].Where(o => PathComparer.Equals(o.Path, file.Path) && !outOfLine.Contains(o)).Select(o => (Id: id, Location: o)))
+                        .OrderBy(o => o.Location.Span.Start)
+                        .ToList();
+
+                    writer.Write7BitEncodedInt(locations.Count);
+                    var offset = 0;
+                    var line = 0;
+                    foreach (var (id, location) in locations)
+                    {
+                        writer.Write7BitEncodedInt(id << 1 | (location.IsDefinition ? 1 : 0));
+                        writer.Write7BitEncodedInt(location.Span.Start - offset);
+                        writer.Write7BitEncodedInt(location.Span.Length);
+                        writer.Write7BitEncodedInt(location.Line - line);
+                        writer.Write7BitEncodedInt(location.Column);
+                        offset = location.Span.Start;
+                        line = location.Line;
+                    }
+
+                    writer.Write7BitEncodedInt(file.Usings.Count);
+                    foreach (var ns in file.Usings)
+                    {
+                        WriteName(writer, ns);
+                    }
+
+                    writer.Write7BitEncodedInt(file.OutOfLine.Count);
+                    foreach (var member in file.OutOfLine)
+                    {
+                        writer.Write7BitEncodedInt(member.Scope);
+                        WriteName(writer, member.Qualifier);
+                        writer.Write(member.Name);
+                        writer.Write((byte)((int)member.Kind << 1 | (member.Location.IsDefinition ? 1 : 0)));
+                        writer.Write7BitEncodedInt(member.Location.Span.Start);
+                        writer.Write7BitEncodedInt(member.Location.Span.Length);
+                        writer.Write7BitEncodedInt(member.Location.Line);
+                        writer.Write7BitEncodedInt(member.Location.Column);
+                    }
+                }
+            }
+        }
+
+        public static CxSymbolIndex Load(Stream stream)
+        {
+            using var reader = new BinaryReader(stream, Encoding.UTF8, leaveOpen: true);
+            try
+            {
+                if (reader.ReadString() != Magic || reader.ReadInt32() != Version)
+                    throw new InvalidDataException("Not a symbol index");
+
+                var names = new string[reader.Read7BitEncodedInt()];
+                for (int i = 0; i < names.Length; ++i)
+                {
+                    names[i] = reader.ReadString();
+                }
+
+                var res = new CxSymbolIndex();
+                for (int count = reader.Read7BitEncodedInt(); count > 0; --count)
+                {
+                    var symbol = new Symbol
+                    {
+                        Parent = reader.Read7BitEncodedInt(),
+                        Name = names[reader.Read7BitEncodedInt()],
+                        Kind = (CxSymbolKind)reader.ReadByte(),
+                    };
+                    res._ids.Add((symbol.Parent, symbol.Name), res._symbols.Count);
+                    res._symbols.Add(symbol);
+                }
+
+                for (int count = reader.Read7BitEncodedInt(); count > 0; --count)
+                {
+                    var file = new FileEntry
+                    {
+                        Path = reader.ReadString(),
+                        Length = reader.ReadInt64(),
+                        LastWriteTicks = reader.ReadInt64(),
+                    };
+                    res._files.Add(file.Path, file);
+
+                    var offset = 0;
+                    var line = 0;
+                    for (int locations = reader.Read7BitEncodedInt(); locations > 0; --locations)
+                    {
+                        var idAndFlag = reader.Read7BitEncodedInt();
+                        offset += reader.Read7BitEncodedInt();
+                        var length = reader.Read7BitEncodedInt();
+                        line += reader.Read7BitEncodedInt();
+                        var column = reader.Read7BitEncodedInt();
+
+                        res.AddLocation(file, idAndFlag >> 1, new CxSymbolLocation(file.Path, new CxSourceSpan(offset, length), line, column, (idAndFlag & 1) != 0));
+                    }
+
+                    for (int usings = reader.Read7BitEncodedInt(); usings > 0; --usings)
+                    {
+                        file.Usings.Add(ReadName(reader));
+                    }
+
+                    for (int members = reader.Read7BitEncodedInt(); members > 0; --members)
+                    {
+                        var member = new OutOfLineMember
+                        {
+                            Scope = reader.Read7BitEncodedInt(),
+                            Qualifier = ReadName(reader),
+                            Name = reader.ReadString(),
+                        };
+                        var kindAndFlag = reader.ReadByte();
+                        member.Kind = (CxSymbolKind)(kindAndFlag >> 1);
+                        member.Location = new CxSymbolLocation(file.Path,
+                            new CxSourceSpan(reader.Read7BitEncodedInt(), reader.Read7BitEncodedInt()),
+                            reader.Read7BitEncodedInt(), reader.Read7BitEncodedInt(), (kindAndFlag & 1) != 0);
+                        if (member.Scope >= res._symbols.Count || member.Qualifier.Length == 0) throw new InvalidDataException("The symbol index is corrupt");
+
+                        file.OutOfLine.Add(member);
+                    }
+                }
+
+                res._resolved = false;
+                return res;
+            }
+            catch (Exception e) when (e is EndOfStreamException || e is IndexOutOfRangeException || e is ArgumentException)
+            {
+                throw new InvalidDataException("The symbol index is corrupt", e);
+            }
+        }
+
+        private bool RemoveLocked(string path)
+        {
+            if (!_files.Remove(path, out var entry)) return false;
+
+            foreach (var member in entry.OutOfLine)
+            {
+                RemoveOutOfLine(member);
+            }
+            foreach (var id in entry.Symbols)
+            {
+                if (!_locations.TryGetValue(id, out var locations)) continue;
+                locations.RemoveAll(o => PathComparer.Equals(o.Path, entry.Path));
+                if (locations.Count == 0) _locations.Remove(id);
+            }
+
+            _resolved = false;
+            return true;
+        }
+
+        private void RemoveOutOfLine(OutOfLineMember member)
+        {
+            if (member.Id < 0) return;
+
+            if (_locations.TryGetValue(member.Id, out var locations))
+            {
+                locations.Remove(member.Location);
+                if (locations.Count == 0) _locations.Remove(member.Id);
+            }
+            member.Id = -1;
+        }
+
+        // Out-of-line members are resolved all at once, since adding or removing a class can
+        // change where any of them belongs.
+        private void ResolveLocked()
+        {
+            if (_resolved) return;
+            _resolved = true;
+
+            foreach (var file in _files.Values)
+            {
+                foreach (var member in file.OutOfLine)
+                {
+                    RemoveOutOfLine(member);
+                }
+            }
+
+            var classes = new Dictionary<string, List<int>>(StringComparer.Ordinal);
+            for (int id = Root + 1; id < _symbols.Count; ++id)
+            {
+                if (!IsDeclaredClass(id)) continue;
+                if (!classes.TryGetValue(_symbols[id].Name, out var ids))
+                {
+                    ids = new List<int>(1);
+                    classes.Add(_symbols[id].Name, ids);
+                }
+                ids.Add(id);
+            }
+
+            foreach (var file in _files.Values)
+            {
+                foreach (var member in file.OutOfLine)
+                {
+                    var id = Intern(ResolveClass(file, member, classes), member.Name, member.Kind);
+                    _symbols[id] = new Symbol { Parent = _symbols[id].Parent, Name = _symbols[id].Name, Kind = member.Kind };
+
+                    if (!_locations.TryGetValue(id, out var locations))
+                    {
+                        locations = new List<CxSymbolLocation>(1);
+                        _locations.Add(id, locations);
+                    }
+                    locations.Add(member.Location);
+                    member.Id = id;
+                }
+            }
+        }
+
+        // The qualifier is looked up from the enclosing namespaces outwards, then from the
+        // file's using-directives, and then taken to be the only indexed class with its last
+        // name. Failing all that, it is kept as written, with every qualifier taken to be a class.
+        private int ResolveClass(FileEntry file, OutOfLineMember member, Dictionary<string, List<int>> classes)
+        {
+            for (var scope = member.Scope; scope >= Root; scope = _symbols[scope].Parent)
+            {
+                var id = FindLocked(scope, member.Qualifier);
+                if (id >= 0 && IsDeclaredClass(id)) return id;
+            }
+
+            foreach (var ns in file.Usings)
+            {
+                var scope = FindLocked(Root, ns);
+                var id = scope < 0 ? -1 : FindLocked(scope, member.Qualifier);
+                if (id >= 0 && IsDeclaredClass(id)) return id;
+            }
+
+            if (classes.TryGetValue(member.Qualifier[^1], out var candidates) && candidates.Count == 1)
+            {
+                return candidates[0];
+            }
+
+            var res = member.Scope;
+            foreach (var part in member.Qualifier)
+            {
+                res = Intern(res, part, CxSymbolKind.Class);
+            }
+            return res;
+        }
+
+        // Classes that only qualify an unresolved out-of-line member have no location.
+        private bool IsDeclaredClass(int id)
+        {
+            return _symbols[id].Kind == CxSymbolKind.Class && _locations.ContainsKey(id);
+        }
+
+        private int FindLocked(int scope, string[] parts)
+        {
+            var id = scope;
+            foreach (var part in parts)
+            {
+                if (!_ids.TryGetValue((id, part), out id)) return -1;
+            }
+
+            return id;
+        }
+
+        private void AddNamespace(FileEntry file, CxNamespace ns, int scope, List<int> lines)
+        {
+            var id = string.IsNullOrEmpty(ns.Namespace) ? scope : Intern(scope, ns.Namespace, CxSymbolKind.Namespace);
+
+            // A `using namespace` applies to the whole file, wherever it appears.
+            foreach (var name in ns.UsingNamespaces)
+            {
+                file.Usings.Add(IndexFiles.SplitName(name));
+            }
+            foreach (var variable in ns.GlobalVariables)
+            {
+                Add(file, id, variable.TypedName?.Name, CxSymbolKind.GlobalVariable, variable.Span, !variable.IsExtern, lines);
+            }
+            foreach (var function in ns.Functions)
+            {
+                Add(file, id, function.Name, CxSymbolKind.Function, function.Span, function.Code != null, lines);
+            }
+            foreach (var cls in ns.Classes)
+            {
+                AddClass(file, cls, id, lines);
+            }
+            foreach (var nested in ns.NestedNamespaces)
+            {
+                AddNamespace(file, nested, id, lines);
+            }
+        }
+
+        private void AddClass(FileEntry file, CxClass cls, int scope, List<int> lines)
+        {
+            var id = Add(file, scope, cls.Name, CxSymbolKind.Class, cls.Span, true, lines);
+            if (id < 0) return;
+
+            foreach (var member in cls.Functions)
+            {
+                Add(file, id, member.Function.Name, CxSymbolKind.Function, member.Function.Span, member.Function.Code != null, lines);
+            }
+            foreach (var nested in cls.NestedClasses)
+            {
+                AddClass(file, nested, id, lines);
+            }
+        }
+
+        private int Add(FileEntry file, int scope, string name, CxSymbolKind kind, CxSourceSpan span, bool isDefinition, List<int> lines)
+        {
+            var parts = IndexFiles.SplitName(name ?? string.Empty);
+            if (parts.Length == 0) return -1;
+
+            var (line, column) = IndexFiles.GetPosition(lines, span.Start);
+            var location = new CxSymbolLocation(file.Path, span, line, column, isDefinition);
+
+            // `App::OnLaunched` defined outside of its class.
+            if (parts.Length > 1 && kind != CxSymbolKind.Class)
+            {
+                file.OutOfLine.Add(new OutOfLineMember { Scope = scope, Qualifier = parts[..^1], Name = parts[^1], Kind = kind, Location = location });
+                return -1;
+            }
+
+            var id = scope;
+            foreach (var part in parts)
+            {
+                id = Intern(id, part, CxSymbolKind.Class);
+            }
+            _symbols[id] = new Symbol { Parent = _symbols[id].Parent, Name = _symbols[id].Name, Kind = kind };
+
+            AddLocation(file, id, location);
+            return id;
+        }
+
+        private void AddLocation(FileEntry file, int id, CxSymbolLocation location)
+        {
+            if (!_locations.TryGetValue(id, out var locations))
+            {
+                locations = new List<CxSymbolLocation>(1);
+                _locations.Add(id, locations);
+            }
+
+            locations.Add(location);
+            file.Symbols.Add(id);
+        }
+
+        private int Intern(int parent, string name, CxSymbolKind kind)
+        {
+            if (_ids.TryGetValue((parent, name), out var id)) return id;
+
+            id = _symbols.Count;
+            _symbols.Add(new Symbol { Parent = parent, Name = name, Kind = kind });
+            _ids.Add((parent, name), id);
+            return id;
+        }
+
+        private static void WriteName(BinaryWriter writer, string[] parts)
+        {
+            writer.Write7BitEncodedInt(parts.Length);
+            foreach (var part in parts)
+            {
+                writer.Write(part);
+            }
+        }
+
+        private static string[] ReadName(BinaryReader reader)
+        {
+            var res = new string[reader.Read7BitEncodedInt()];
+            for (int i = 0; i < res.Length; ++i)
+            {
+                res[i] = reader.ReadString();
+            }
+            return res;
+        }
+    }
+}
@@ -0,0 +1,20 @@
+﻿using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Indexing
+{
+    public enum CxSymbolKind : byte
+    {
+        Namespace, Class, Function, GlobalVariable
+    }
+
+    // Line is 1-based and Column 0-based, like ANTLR token positions.
+    public record CxSymbolLocation(string Path, CxSourceSpan Span, int Line, int Column, bool IsDefinition)
+    {
+        public override string ToString() => $"{Path}({Line},{Column + 1})";
+    }
+}
@@ -0,0 +1,69 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Indexing
+{
+    // Helpers shared by the symbol and identifier indexes.
+    internal static class IndexFiles
+    {
+        // The size and write time recorded for a file, or zeros when it doesn't exist.
+        public static (long Length, long LastWriteTicks) GetStamp(FileInfo file)
+        {
+            return file.Exists ? (file.Length, file.LastWriteTimeUtc.Ticks) : (0, 0);
+        }
+
+        // True when the file still has the recorded size and write time.
+        public static bool IsUnchanged(FileInfo file, long length, long lastWriteTicks)
+        {
+            return file.Exists && length == file.Length && lastWriteTicks == file.LastWriteTimeUtc.Ticks;
+        }
+
+        // Writes to a temporary file first, so a failed save doesn't leave a truncated index.
+        public static void Save(string filename, Action<Stream> save)
+        {
+            var tmp = filename + ".tmp";
+            using (var stream = File.Create(tmp))
+            {
+                save(stream);
+            }
+            File.Move(tmp, filename, true);
+        }
+
+        public static T Load<T>(string filename, Func<Stream, T> load)
+        {
+            using var stream = File.OpenRead(filename);
+            return load(stream);
+        }
+
+        // `Calculator::App::OnLaunched` => [Calculator, App, OnLaunched]
+        public static string[] SplitName(string name)
+        {
+            return name.Split("::", StringSplitOptions.RemoveEmptyEntries | StringSplitOptions.TrimEntries);
+        }
+
+        public static List<int> GetLineStarts(ReadOnlySpan<char> text)
+        {
+            var res = new List<int> { 0 };
+            for (int i = 0; i < text.Length; ++i)
+            {
+                if (text[i] == '\n') res.Add(i + 1);
+            }
+
+            return res;
+        }
+
+        // Line is 1-based and Column 0-based. Without line starts, both are 0.
+        public static (int Line, int Column) GetPosition(List<int> lines, int offset)
+        {
+            if (lines == null) return (0, 0);
+
+            var index = lines.BinarySearch(offset);
+            if (index < 0) index = ~index - 1;
+            return (index + 1, offset - lines[index]);
+        }
+    }
+}
@@ -1,4 +1,5 @@
-﻿using System;
+﻿using cppcx.Core.Parsing;
+using System;
 using System.Collections.Generic;
 using System.Text;
 
@@ -12,5 +13,6 @@ namespace cppcx.Core.Models
         public List<CxClass> NestedClasses { get; init; } = new List<CxClass>();
         public bool IsSealed { get; set; } = false;
         public bool IsFinal { get; set; } = false;
+        public CxSourceSpan Span { get; set; }
     }
 }
@@ -1,14 +1,50 @@
 ﻿using Antlr4.Runtime;
+using cppcx.Core.Parsing;
 using System;
 using System.Collections.Generic;
+using System.IO;
 using System.Linq;
 using System.Text;
+using System.Text.Json.Serialization;
 using System.Threading.Tasks;
 
 namespace cppcx.Core.Models
 {
     public class CxCode
     {
+        [JsonIgnore]
         public ParserRuleContext Context { get; set; }
+        public string SourceName { get; set; }
+        public CxSourceSpan Span { get; set; }
+        public int RuleIndex { get; set; } = -1;
+        // Length and hash of the whole source text the span refers to, checked before a
+        // detached block is parsed again. Null when the source wasn't known.
+        public int SourceLength { get; set; } = -1;
+        public string SourceHash { get; set; }
+
+        [JsonIgnore]
+        public bool IsDetached => Context == null;
+
+        // A detached code block is parsed again from its file on every call, so that the
+        // model never keeps a parse tree alive. Throws InvalidOperationException when the file
+        // is gone or no longer has the text the span was taken from.
+        public ParserRuleContext GetContext()
+        {
+            if (Context != null) return Context;
+
+            if (SourceName == null || !File.Exists(SourceName))
+                throw new InvalidOperationException($"The source of a detached code block is not available: {SourceName ?? IntStreamConstants.UnknownSourceName}");
+
+            var source = CxSourceText.FromFile(SourceName);
+            if (SourceHash != null && (source.Size != SourceLength || CxSourceText.ComputeHash(source.Memory.Span) != SourceHash))
+                throw new InvalidOperationException($"{SourceName} has changed since its model was built");
+
+            return CxSpanParser.Parse(source, Span, RuleIndex);
+        }
+
+        public void Detach()
+        {
+            Context = null;
+        }
     }
 }
@@ -1,4 +1,5 @@
-﻿using System;
+﻿using cppcx.Core.Parsing;
+using System;
 using System.Collections.Generic;
 using System.Linq;
 using System.Text;
@@ -13,5 +14,7 @@ namespace cppcx.Core.Models
         public List<CxParameter> Parameters { get; init; } = new List<CxParameter>();
         public bool IsStatic { get; set; } = false;
         public CxCode Code { get; set; }
+        // The declaration or definition the function was read from.
+        public CxSourceSpan Span { get; set; }
     }
 }
@@ -1,4 +1,5 @@
-﻿using System;
+﻿using cppcx.Core.Parsing;
+using System;
 using System.Collections.Generic;
 using System.Text;
 
@@ -9,6 +10,7 @@ namespace cppcx.Core.Models
         public CxTypedName TypedName { get; set; }
         public string InitValue { get; set; } = null;
         public bool IsExtern { get; set; } = false;
+        public CxSourceSpan Span { get; set; }
 
         public override bool Equals(object obj)
         {
@@ -13,5 +13,7 @@ namespace cppcx.Core.Models
         public List<CxGlobalVariable> GlobalVariables { get; init; } = new List<CxGlobalVariable>();
         public List<CxFunction> Functions { get; init; } = new List<CxFunction>();
         public List<CxClass> Classes { get; init; } = new List<CxClass>();
+        // `using namespace` directives directly in this namespace, as written, e.g. `Platform`.
+        public List<string> UsingNamespaces { get; init; } = new List<string>();
     }
 }
@@ -0,0 +1,182 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Atn;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Text.Json;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Parses with ANTLR's ProfilingATNSimulator and reports what each grammar decision costs,
+    // summed over every file parsed by this instance.
+    public class CxDecisionProfiler
+    {
+        public class DecisionStats
+        {
+            public int Decision { get; init; }
+            public string Rule { get; init; }
+            public long Invocations { get; init; }
+            public double TimeMs { get; init; }
+            public long SllTotalLook { get; init; }
+            public long SllMaxLook { get; init; }
+            public long LlTotalLook { get; init; }
+            public long LlMaxLook { get; init; }
+            public long LlFallbacks { get; init; }
+            public long ContextSensitivities { get; init; }
+            public long Ambiguities { get; init; }
+            public long Errors { get; init; }
+
+            public double AverageSllLook => Invocations == 0 ? 0 : (double)SllTotalLook / Invocations;
+            public double AverageLlLook => LlFallbacks == 0 ? 0 : (double)LlTotalLook / LlFallbacks;
+        }
+
+        public class RuleStats
+        {
+            public string Rule { get; init; }
+            public int Decisions { get; init; }
+            public long Invocations { get; init; }
+            public double TimeMs { get; init; }
+            public long LlFallbacks { get; init; }
+            public long Ambiguities { get; init; }
+        }
+
+        private class ProfilingParser : CPPCXParser
+        {
+            public ProfilingATNSimulator Simulator { get; }
+
+            public ProfilingParser() : base(null)
+            {
+                Simulator = new ProfilingATNSimulator(this);
+                Interpreter = Simulator;
+            }
+        }
+
+        private readonly CPPCXLexer _lexer;
+        private readonly ProfilingParser _parser;
+        private readonly SyntaxErrorCollector _errors = new SyntaxErrorCollector();
+
+        public int Files { get; private set; } = 0;
+
+        public CxDecisionProfiler()
+        {
+            _lexer = new CPPCXLexer(null);
+            _lexer.RemoveErrorListeners();
+            _lexer.AddErrorListener(_errors);
+
+            _parser = new ProfilingParser();
+            _parser.RemoveErrorListeners();
+            _parser.AddErrorListener(_errors);
+        }
+
+        public CxParseResult ParseFile(string filename)
+        {
+            return Parse(CxSourceText.FromFile(filename));
+        }
+
+        // Always full LL: it tries SLL per decision first, so the report shows which decisions
+        // need the full context.
+        public CxParseResult Parse(ICharStream input)
+        {
+            return CxDfaCache.Read(() => ParseLocked(input));
+        }
+
+        private CxParseResult ParseLocked(ICharStream input)
+        {
+            var sw = Stopwatch.StartNew();
+            _errors.Clear();
+
+            _lexer.SetInputStream(input);
+            var tokens = new CommonTokenStream(_lexer);
+            _parser.TokenStream = tokens;
+            _parser.Interpreter.PredictionMode = PredictionMode.LL;
+            var tu = _parser.translationUnit();
+            ++Files;
+
+            return new CxParseResult
+            {
+                SourceName = input.SourceName,
+                TranslationUnit = tu,
+                Tokens = tokens,
+                SyntaxErrors = _errors.Errors.ToList(),
+                PredictionStrategy = CxPredictionStrategy.LL,
+                Elapsed = sw.Elapsed,
+            };
+        }
+
+        // Invoked decisions, most expensive first.
+        public List<DecisionStats> GetDecisions()
+        {
+            var atn = CPPCXParser._ATN;
+            return _parser.Simulator.getDecisionInfo()
+                .Where(o => o.invocations > 0)
+                .Select(o => new DecisionStats
+                {
+                    Decision = o.decision,
+                    Rule = _parser.RuleNames[atn.decisionToState[o.decision].ruleIndex],
+                    Invocations = o.invocations,
+                    // The C# runtime measures prediction time in DateTime ticks.
+                    TimeMs = TimeSpan.FromTicks(o.timeInPrediction).TotalMilliseconds,
+                    SllTotalLook = o.SLL_TotalLook,
+                    SllMaxLook = o.SLL_MaxLook,
+                    LlTotalLook = o.LL_TotalLook,
+                    LlMaxLook = o.LL_MaxLook,
+                    LlFallbacks = o.LL_Fallback,
+                    ContextSensitivities = o.contextSensitivities.Count,
+                    Ambiguities = o.ambiguities.Count,
+                    Errors = o.errors.Count,
+                })
+                .OrderByDescending(o => o.TimeMs)
+                .ThenByDescending(o => o.SllTotalLook + o.LlTotalLook)
+                .ToList();
+        }
+
+        public List<RuleStats> GetRules()
+        {
+            return GetDecisions()
+                .GroupBy(o => o.Rule)
+                .Select(o => new RuleStats
+                {
+                    Rule = o.Key,
+                    Decisions = o.Count(),
+                    Invocations = o.Sum(d => d.Invocations),
+                    TimeMs = o.Sum(d => d.TimeMs),
+                    LlFallbacks = o.Sum(d => d.LlFallbacks),
+                    Ambiguities = o.Sum(d => d.Ambiguities),
+                })
+                .OrderByDescending(o => o.TimeMs)
+                .ToList();
+        }
+
+        public static void WriteCsv(TextWriter writer, IEnumerable<DecisionStats> decisions)
+        {
+            writer.WriteLine("decision,rule,invocations,time_ms,sll_avg_look,sll_max_look,ll_fallbacks,ll_avg_look,ll_max_look,context_sensitivities,ambiguities,errors");
+            foreach (var o in decisions)
+            {
+                writer.WriteLine(string.Join(",",
+                    o.Decision.ToString(CultureInfo.InvariantCulture),
+                    o.Rule,
+                    o.Invocations.ToString(CultureInfo.InvariantCulture),
+                    o.TimeMs.ToString("F3", CultureInfo.InvariantCulture),
+                    o.AverageSllLook.ToString("F2", CultureInfo.InvariantCulture),
+                    o.SllMaxLook.ToString(CultureInfo.InvariantCulture),
+                    o.LlFallbacks.ToString(CultureInfo.InvariantCulture),
+                    o.AverageLlLook.ToString("F2", CultureInfo.InvariantCulture),
+                    o.LlMaxLook.ToString(CultureInfo.InvariantCulture),
+                    o.ContextSensitivities.ToString(CultureInfo.InvariantCulture),
+                    o.Ambiguities.ToString(CultureInfo.InvariantCulture),
+                    o.Errors.ToString(CultureInfo.InvariantCulture)));
+            }
+        }
+
+        public static void WriteJson(Stream stream, IEnumerable<DecisionStats> decisions)
+        {
+            using var writer = new Utf8JsonWriter(stream, new JsonWriterOptions { Indented = true });
+            JsonSerializer.Serialize(writer, decisions.ToList());
+        }
+    }
+}
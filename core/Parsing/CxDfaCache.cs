@@ -0,0 +1,152 @@
+﻿using Antlr4.Runtime.Atn;
+using Antlr4.Runtime.Dfa;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Access to the DFA cache that the generated lexer and parser keep in protected statics.
+    // The cache is shared by every recognizer in the process, so every lex or parse holds the
+    // read lock, and replacing or enumerating the DFAs takes the write lock.
+    //
+    // The DFA states reference prediction contexts that are also kept in the shared context
+    // caches, so those are replaced along with the DFAs. Recognizers capture the caches when
+    // they are created; long-lived ones compare Generation and create new recognizers after
+    // a replacement, so the old contexts can be collected.
+    internal static class CxDfaCache
+    {
+        private static readonly ReaderWriterLockSlim Lock = new ReaderWriterLockSlim(LockRecursionPolicy.SupportsRecursion);
+        private static int _generation = 0;
+        private static volatile bool _clearPending = false;
+
+        public static int Generation => Volatile.Read(ref _generation);
+
+        private sealed class ParserDfa : CPPCXParser
+        {
+            private ParserDfa() : base(null)
+            {
+            }
+
+            public static DFA[] Decisions => decisionToDFA;
+
+            public static void ResetContextCache()
+            {
+                sharedContextCache = new PredictionContextCache();
+            }
+        }
+
+        private sealed class LexerDfa : CPPCXLexer
+        {
+            private LexerDfa() : base(null)
+            {
+            }
+
+            public static DFA[] Decisions => decisionToDFA;
+
+            public static void ResetContextCache()
+            {
+                sharedContextCache = new PredictionContextCache();
+            }
+        }
+
+        public static DFA[] ParserDecisions => ParserDfa.Decisions;
+        public static DFA[] LexerDecisions => LexerDfa.Decisions;
+
+        public static T Read<T>(Func<T> action)
+        {
+            Lock.EnterReadLock();
+            try
+            {
+                return action();
+            }
+            finally
+            {
+                Lock.ExitReadLock();
+                if (_clearPending && !Lock.IsReadLockHeld) Clear();
+            }
+        }
+
+        // The read lock can't be upgraded, so the DFAs can't be replaced from inside a parse on
+        // the same thread, e.g. from a parse listener.
+        public static T Write<T>(Func<T> action)
+        {
+            EnterWriteLock();
+            try
+            {
+                return action();
+            }
+            finally
+            {
+                Lock.ExitWriteLock();
+            }
+        }
+
+        public static void Write(Action action)
+        {
+            EnterWriteLock();
+            try
+            {
+                action();
+            }
+            finally
+            {
+                Lock.ExitWriteLock();
+            }
+        }
+
+        private static void EnterWriteLock()
+        {
+            if (Lock.IsReadLockHeld && !Lock.IsWriteLockHeld)
+                throw new InvalidOperationException("The DFA cache can't be replaced while this thread is parsing");
+
+            Lock.EnterWriteLock();
+        }
+
+        public static int CountStates()
+        {
+            return ParserDecisions.Sum(o => o.states.Count) + LexerDecisions.Sum(o => o.states.Count);
+        }
+
+        // Called from inside a parse, the clear is deferred until the thread leaves it.
+        public static void Clear()
+        {
+            if (Lock.IsReadLockHeld && !Lock.IsWriteLockHeld)
+            {
+                _clearPending = true;
+                return;
+            }
+
+            Write(ClearDecisions);
+        }
+
+        // Drops the contexts merged by prediction so far. Only called under the write lock.
+        public static void ResetContextCaches()
+        {
+            ParserDfa.ResetContextCache();
+            LexerDfa.ResetContextCache();
+            Interlocked.Increment(ref _generation);
+        }
+
+        private static void ClearDecisions()
+        {
+            var parser = ParserDecisions;
+            for (int i = 0; i < parser.Length; ++i)
+            {
+                parser[i] = new DFA(CPPCXParser._ATN.GetDecisionState(i), i);
+            }
+
+            var lexer = LexerDecisions;
+            for (int i = 0; i < lexer.Length; ++i)
+            {
+                lexer[i] = new DFA(CPPCXLexer._ATN.GetDecisionState(i), i);
+            }
+
+            ResetContextCaches();
+            _clearPending = false;
+        }
+    }
+}
@@ -0,0 +1,428 @@
+﻿using Antlr4.Runtime.Atn;
+using Antlr4.Runtime.Dfa;
+using Antlr4.Runtime.Sharpen;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Saves the parser's prediction DFAs after a training run and loads them into a fresh
+    // process, so the first files are not parsed with a cold cache. States are stored with
+    // their ATN configurations, since prediction extends the DFA from them on a cache miss.
+    // The lexer DFA is small and warms up within the first file, so it is not stored.
+    //
+    // Saving and swapping in loaded DFAs take the DFA cache's write lock, so they wait for
+    // running parses.
+    public static class CxDfaSnapshot
+    {
+        private const string Magic = "CXDFA";
+        private const int Version = 1;
+        private const int ErrorState = -2;
+
+        private enum SemanticKind : byte
+        {
+            None, Predicate, Precedence, And, Or
+        }
+
+        public static void SaveFile(string filename)
+        {
+            using var stream = File.Create(filename);
+            Save(stream);
+        }
+
+        public static int LoadFile(string filename)
+        {
+            using var stream = File.OpenRead(filename);
+            return Load(stream);
+        }
+
+        public static byte[] GetGrammarFingerprint()
+        {
+            return SHA256.HashData(Encoding.UTF8.GetBytes(new CPPCXParser(null).SerializedAtn));
+        }
+
+        public static void Save(Stream stream)
+        {
+            CxDfaCache.Write(() => SaveLocked(stream));
+        }
+
+        private static void SaveLocked(Stream stream)
+        {
+            var decisions = CxDfaCache.ParserDecisions
+                .Where(o => o.states.Count > 0)
+                .ToList();
+
+            var contexts = new Dictionary<PredictionContext, int>(ReferenceEqualityComparer.Instance);
+            var contextList = new List<PredictionContext>();
+            foreach (var dfa in decisions)
+            {
+                foreach (var state in dfa.states.Keys)
+                {
+                    foreach (var config in state.configSet.configs)
+                    {
+                        AddContext(config.context, contexts, contextList);
+                    }
+                }
+            }
+
+            using var writer = new BinaryWriter(stream, Encoding.UTF8, leaveOpen: true);
+            writer.Write(Magic);
+            writer.Write(Version);
+            writer.Write(GetGrammarFingerprint());
+
+            writer.Write(contextList.Count);
+            foreach (var ctx in contextList)
+            {
+                writer.Write(ctx.Size);
+                for (int i = 0; i < ctx.Size; ++i)
+                {
+                    var parent = ctx.GetParent(i);
+                    writer.Write(parent == null ? -1 : contexts[parent]);
+                    writer.Write(ctx.GetReturnState(i));
+                }
+            }
+
+            writer.Write(decisions.Count);
+            foreach (var dfa in decisions)
+            {
+                var states = dfa.states.Keys.ToList();
+                var ids = new Dictionary<DFAState, int>(ReferenceEqualityComparer.Instance);
+                for (int i = 0; i < states.Count; ++i)
+                {
+                    ids.Add(states[i], i);
+                }
+
+                writer.Write(dfa.decision);
+                writer.Write(states.Count);
+                foreach (var state in states)
+                {
+                    WriteState(writer, state, contexts);
+                }
+                foreach (var state in states)
+                {
+                    WriteEdges(writer, state.edges, ids);
+                }
+
+                writer.Write(dfa.IsPrecedenceDfa);
+                if (dfa.IsPrecedenceDfa)
+                {
+                    WriteEdges(writer, dfa.s0?.edges, ids);
+                }
+                else
+                {
+                    writer.Write(dfa.s0 != null && ids.TryGetValue(dfa.s0, out var s0) ? s0 : -1);
+                }
+            }
+        }
+
+        // Replaces the DFA of every stored decision and returns the number of states loaded.
+        public static int Load(Stream stream)
+        {
+            using var reader = new BinaryReader(stream, Encoding.UTF8, leaveOpen: true);
+            try
+            {
+                return Load(reader);
+            }
+            catch (EndOfStreamException e)
+            {
+                throw new InvalidDataException("The DFA snapshot is truncated", e);
+            }
+        }
+
+        private static int Load(BinaryReader reader)
+        {
+            if (reader.ReadString() != Magic || reader.ReadInt32() != Version)
+                throw new InvalidDataException("Not a DFA snapshot");
+            if (!reader.ReadBytes(32).SequenceEqual(GetGrammarFingerprint()))
+                throw new InvalidDataException("The DFA snapshot was saved for a different grammar");
+
+            var atn = CPPCXParser._ATN;
+
+            var contexts = new PredictionContext[reader.ReadInt32()];
+            for (int i = 0; i < contexts.Length; ++i)
+            {
+                var size = reader.ReadInt32();
+                var parents = new PredictionContext[size];
+                var returnStates = new int[size];
+                for (int j = 0; j < size; ++j)
+                {
+                    var parent = reader.ReadInt32();
+                    parents[j] = parent < 0 ? null : contexts[parent];
+                    returnStates[j] = reader.ReadInt32();
+                }
+
+                contexts[i] = size == 1
+                    ? SingletonPredictionContext.Create(parents[0], returnStates[0])
+                    : new ArrayPredictionContext(parents, returnStates);
+            }
+
+            var loaded = new List<DFA>();
+            var res = 0;
+            for (int count = reader.ReadInt32(); count > 0; --count)
+            {
+                var decision = reader.ReadInt32();
+                var dfa = new DFA(atn.GetDecisionState(decision), decision);
+
+                var states = new DFAState[reader.ReadInt32()];
+                for (int i = 0; i < states.Length; ++i)
+                {
+                    states[i] = ReadState(reader, atn, contexts);
+                    states[i].stateNumber = i;
+                    dfa.states[states[i]] = states[i];
+                }
+                foreach (var state in states)
+                {
+                    state.edges = ReadEdges(reader, states);
+                }
+
+                if (reader.ReadBoolean())
+                {
+                    var starts = ReadEdges(reader, states);
+                    for (int precedence = 0; starts != null && precedence < starts.Length; ++precedence)
+                    {
+                        if (starts[precedence] != null) dfa.SetPrecedenceStartState(precedence, starts[precedence]);
+                    }
+                }
+                else
+                {
+                    var s0 = reader.ReadInt32();
+                    dfa.s0 = s0 < 0 ? null : states[s0];
+                }
+
+                loaded.Add(dfa);
+                res += states.Length;
+            }
+
+            // Only swap the DFAs in once the whole snapshot has been read.
+            CxDfaCache.Write(() =>
+            {
+                var decisions = CxDfaCache.ParserDecisions;
+                foreach (var dfa in loaded)
+                {
+                    decisions[dfa.decision] = dfa;
+                }
+                CxDfaCache.ResetContextCaches();
+            });
+
+            return res;
+        }
+
+        private static void AddContext(PredictionContext ctx, Dictionary<PredictionContext, int> contexts, List<PredictionContext> contextList)
+        {
+            if (ctx == null || contexts.ContainsKey(ctx)) return;
+
+            // Parents first, so loading can resolve them by index.
+            for (int i = 0; i < ctx.Size; ++i)
+            {
+                AddContext(ctx.GetParent(i), contexts, contextList);
+            }
+
+            contexts.Add(ctx, contextList.Count);
+            contextList.Add(ctx);
+        }
+
+        private static void WriteState(BinaryWriter writer, DFAState state, Dictionary<PredictionContext, int> contexts)
+        {
+            var configs = state.configSet;
+            writer.Write(configs.fullCtx);
+            writer.Write(configs.configs.Count);
+            foreach (var config in configs.configs)
+            {
+                writer.Write(config.state.stateNumber);
+                writer.Write(config.alt);
+                writer.Write(config.context == null ? -1 : contexts[config.context]);
+                WriteSemanticContext(writer, config.semanticContext);
+                writer.Write(config.reachesIntoOuterContext);
+            }
+            writer.Write(configs.uniqueAlt);
+            WriteBits(writer, configs.conflictingAlts);
+            writer.Write(configs.hasSemanticContext);
+            writer.Write(configs.dipsIntoOuterContext);
+
+            writer.Write(state.isAcceptState);
+            writer.Write(state.prediction);
+            writer.Write(state.requiresFullContext);
+            writer.Write(state.predicates?.Length ?? -1);
+            foreach (var predicate in state.predicates ?? Array.Empty<DFAState.PredPrediction>())
+            {
+                WriteSemanticContext(writer, predicate.pred);
+                writer.Write(predicate.alt);
+            }
+        }
+
+        private static DFAState ReadState(BinaryReader reader, ATN atn, PredictionContext[] contexts)
+        {
+            var configs = new ATNConfigSet(reader.ReadBoolean());
+            for (int count = reader.ReadInt32(); count > 0; --count)
+            {
+                var atnState = atn.states[reader.ReadInt32()];
+                var alt = reader.ReadInt32();
+                var context = reader.ReadInt32();
+                var config = new ATNConfig(atnState, alt, context < 0 ? null : contexts[context], ReadSemanticContext(reader));
+                config.reachesIntoOuterContext = reader.ReadInt32();
+                configs.Add(config);
+            }
+            configs.uniqueAlt = reader.ReadInt32();
+            configs.conflictingAlts = ReadBits(reader);
+            configs.hasSemanticContext = reader.ReadBoolean();
+            configs.dipsIntoOuterContext = reader.ReadBoolean();
+            configs.IsReadOnly = true;
+
+            var state = new DFAState(configs)
+            {
+                isAcceptState = reader.ReadBoolean(),
+                prediction = reader.ReadInt32(),
+                requiresFullContext = reader.ReadBoolean(),
+            };
+
+            var predicates = reader.ReadInt32();
+            if (predicates >= 0)
+            {
+                state.predicates = new DFAState.PredPrediction[predicates];
+                for (int i = 0; i < predicates; ++i)
+                {
+                    var pred = ReadSemanticContext(reader);
+                    state.predicates[i] = new DFAState.PredPrediction(pred, reader.ReadInt32());
+                }
+            }
+
+            return state;
+        }
+
+        private static void WriteEdges(BinaryWriter writer, DFAState[] edges, Dictionary<DFAState, int> ids)
+        {
+            if (edges == null)
+            {
+                writer.Write(-1);
+                return;
+            }
+
+            writer.Write(edges.Length);
+            var targets = edges
+                .Select((target, index) => (target, index))
+                .Where(o => o.target != null && (o.target == ATNSimulator.ERROR || ids.ContainsKey(o.target)))
+                .ToList();
+
+            writer.Write(targets.Count);
+            foreach (var (target, index) in targets)
+            {
+                writer.Write(index);
+                writer.Write(target == ATNSimulator.ERROR ? ErrorState : ids[target]);
+            }
+        }
+
+        private static DFAState[] ReadEdges(BinaryReader reader, DFAState[] states)
+        {
+            var length = reader.ReadInt32();
+            if (length < 0) return null;
+
+            var edges = new DFAState[length];
+            for (int count = reader.ReadInt32(); count > 0; --count)
+            {
+                var index = reader.ReadInt32();
+                var target = reader.ReadInt32();
+                edges[index] = target == ErrorState ? ATNSimulator.ERROR : states[target];
+            }
+
+            return edges;
+        }
+
+        private static void WriteSemanticContext(BinaryWriter writer, SemanticContext ctx)
+        {
+            // NONE is itself a Predicate, so it has to be checked first.
+            if (ctx == null || ctx == SemanticContext.NONE)
+            {
+                writer.Write((byte)SemanticKind.None);
+                return;
+            }
+
+            switch (ctx)
+            {
+                case SemanticContext.PrecedencePredicate precedence:
+                    writer.Write((byte)SemanticKind.Precedence);
+                    writer.Write(precedence.precedence);
+                    break;
+                case SemanticContext.Predicate predicate:
+                    writer.Write((byte)SemanticKind.Predicate);
+                    writer.Write(predicate.ruleIndex);
+                    writer.Write(predicate.predIndex);
+                    writer.Write(predicate.isCtxDependent);
+                    break;
+                case SemanticContext.AND and:
+                    writer.Write((byte)SemanticKind.And);
+                    writer.Write(and.opnds.Length);
+                    foreach (var operand in and.opnds) WriteSemanticContext(writer, operand);
+                    break;
+                case SemanticContext.OR or:
+                    writer.Write((byte)SemanticKind.Or);
+                    writer.Write(or.opnds.Length);
+                    foreach (var operand in or.opnds) WriteSemanticContext(writer, operand);
+                    break;
+                default:
+                    throw new NotSupportedException($"Unknown semantic context {ctx.GetType().Name}");
+            }
+        }
+
+        private static SemanticContext ReadSemanticContext(BinaryReader reader)
+        {
+            var kind = (SemanticKind)reader.ReadByte();
+            switch (kind)
+            {
+                case SemanticKind.None:
+                    return SemanticContext.NONE;
+                case SemanticKind.Precedence:
+                    return new SemanticContext.PrecedencePredicate(reader.ReadInt32());
+                case SemanticKind.Predicate:
+                    return new SemanticContext.Predicate(reader.ReadInt32(), reader.ReadInt32(), reader.ReadBoolean());
+                case SemanticKind.And:
+                case SemanticKind.Or:
+                    var count = reader.ReadInt32();
+                    var res = ReadSemanticContext(reader);
+                    for (int i = 1; i < count; ++i)
+                    {
+                        var operand = ReadSemanticContext(reader);
+                        res = kind == SemanticKind.And ? SemanticContext.AndOp(res, operand) : SemanticContext.OrOp(res, operand);
+                    }
+                    return res;
+                default:
+                    throw new InvalidDataException("Unknown semantic context in DFA snapshot");
+            }
+        }
+
+        private static void WriteBits(BinaryWriter writer, BitSet bits)
+        {
+            if (bits == null)
+            {
+                writer.Write(-1);
+                return;
+            }
+
+            var set = new List<int>();
+            for (int i = bits.NextSetBit(0); i >= 0; i = bits.NextSetBit(i + 1))
+            {
+                set.Add(i);
+            }
+
+            writer.Write(set.Count);
+            foreach (var i in set) writer.Write(i);
+        }
+
+        private static BitSet ReadBits(BinaryReader reader)
+        {
+            var count = reader.ReadInt32();
+            if (count < 0) return null;
+
+            var bits = new BitSet();
+            for (; count > 0; --count)
+            {
+                bits.Set(reader.ReadInt32());
+            }
+            return bits;
+        }
+    }
+}
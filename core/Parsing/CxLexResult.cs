@@ -0,0 +1,19 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Tokens of a fully lexed file, ready to be parsed by any worker.
+    public class CxLexResult
+    {
+        public ICharStream Input { get; init; }
+        public ITokenStream Tokens { get; init; }
+        public List<CxSyntaxError> SyntaxErrors { get; init; } = new List<CxSyntaxError>();
+        public Dictionary<int, SkippedFunctionBody> SkippedBodies { get; init; } = new Dictionary<int, SkippedFunctionBody>();
+        public TimeSpan Elapsed { get; init; }
+    }
+}
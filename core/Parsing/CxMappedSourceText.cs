@@ -0,0 +1,242 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using System;
+using System.Buffers;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // A char stream over a memory-mapped source file. The file is split into blocks; ASCII
+    // blocks are read in place from the mapping, and only blocks with other UTF-8 sequences
+    // are decoded into pooled char arrays. Indexes are UTF-16 units like CxSourceText, so
+    // spans from either stream are interchangeable.
+    //
+    // Tokens read their text from the stream, so it has to outlive the tree built from it.
+    public sealed unsafe class CxMappedSourceText : ICharStream, IDisposable
+    {
+        private const int BlockSize = 64 * 1024;
+
+        private struct Block
+        {
+            public int CharStart;
+            public int CharLength;
+            public int ByteStart;
+            public char[] Chars;
+        }
+
+        private readonly MemoryMappedFile _file;
+        private readonly MemoryMappedViewAccessor _view;
+        private readonly byte* _bytes;
+        private readonly Block[] _blocks;
+        private int _size;
+        private int _p = 0;
+        private int _block = 0;
+        private bool _disposed = false;
+
+        public string SourceName { get; }
+        public int Index => _p;
+        public int Size => _size;
+        public int DecodedChars => _blocks.Where(o => o.Chars != null).Sum(o => o.CharLength);
+
+        private CxMappedSourceText(string filename)
+        {
+            SourceName = filename;
+
+            var length = new FileInfo(filename).Length;
+            if (length > int.MaxValue) throw new NotSupportedException($"{filename} is too large to be parsed");
+
+            if (length > 0)
+            {
+                _file = MemoryMappedFile.CreateFromFile(filename, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+                _view = _file.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+
+                byte* ptr = null;
+                _view.SafeMemoryMappedViewHandle.AcquirePointer(ref ptr);
+                _bytes = ptr + _view.PointerOffset;
+            }
+
+            _blocks = Split(new ReadOnlySpan<byte>(_bytes, (int)length), out _size);
+        }
+
+        public static CxMappedSourceText Open(string filename)
+        {
+            return new CxMappedSourceText(filename);
+        }
+
+        private static Block[] Split(ReadOnlySpan<byte> bytes, out int size)
+        {
+            var blocks = new List<Block>();
+            size = 0;
+
+            // UTF-16 files are rare enough to simply be decoded as a whole.
+            if (bytes.Length >= 2 && ((bytes[0] == 0xFF && bytes[1] == 0xFE) || (bytes[0] == 0xFE && bytes[1] == 0xFF)))
+            {
+                var encoding = bytes[0] == 0xFF ? Encoding.Unicode : Encoding.BigEndianUnicode;
+                blocks.Add(Decode(encoding, bytes[2..], 2, 0));
+                size = blocks[0].CharLength;
+                return blocks.ToArray();
+            }
+
+            var pos = bytes.Length >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF ? 3 : 0;
+            while (pos < bytes.Length)
+            {
+                var end = Math.Min(pos + BlockSize, bytes.Length);
+
+                // Don't split a UTF-8 sequence between two blocks.
+                while (end < bytes.Length && end > pos + 1 && (bytes[end] & 0xC0) == 0x80) --end;
+
+                var slice = bytes[pos..end];
+                var block = IsAscii(slice)
+                    ? new Block { CharStart = size, CharLength = slice.Length, ByteStart = pos }
+                    : Decode(Encoding.UTF8, slice, pos, size);
+
+                blocks.Add(block);
+                size += block.CharLength;
+                pos = end;
+            }
+
+            return blocks.ToArray();
+        }
+
+        private static Block Decode(Encoding encoding, ReadOnlySpan<byte> bytes, int byteStart, int charStart)
+        {
+            var chars = ArrayPool<char>.Shared.Rent(Math.Max(1, encoding.GetCharCount(bytes)));
+            return new Block
+            {
+                CharStart = charStart,
+                CharLength = encoding.GetChars(bytes, chars),
+                ByteStart = byteStart,
+                Chars = chars,
+            };
+        }
+
+        private static bool IsAscii(ReadOnlySpan<byte> bytes)
+        {
+            var words = MemoryMarshal.Cast<byte, ulong>(bytes);
+            foreach (var word in words)
+            {
+                if ((word & 0x8080808080808080UL) != 0) return false;
+            }
+
+            for (int i = words.Length * sizeof(ulong); i < bytes.Length; ++i)
+            {
+                if (bytes[i] >= 0x80) return false;
+            }
+
+            return true;
+        }
+
+        private int FindBlock(int index)
+        {
+            // Lexing is sequential, so the current or the next block almost always matches.
+            var block = _blocks[_block];
+            if (index >= block.CharStart && index < block.CharStart + block.CharLength) return _block;
+
+            int lo = 0, hi = _blocks.Length - 1;
+            while (lo < hi)
+            {
+                var mid = (lo + hi + 1) / 2;
+                if (_blocks[mid].CharStart <= index) lo = mid;
+                else hi = mid - 1;
+            }
+
+            return _block = lo;
+        }
+
+        private char CharAt(int index)
+        {
+            ref var block = ref _blocks[FindBlock(index)];
+            var offset = index - block.CharStart;
+            return block.Chars != null ? block.Chars[offset] : (char)_bytes[block.ByteStart + offset];
+        }
+
+        public void Consume()
+        {
+            if (_p >= _size) throw new InvalidOperationException("cannot consume EOF");
+            ++_p;
+        }
+
+        public int LA(int i)
+        {
+            if (i == 0) return 0;
+            if (i < 0) ++i;
+
+            var index = _p + i - 1;
+            if (index < 0 || index >= _size) return IntStreamConstants.EOF;
+            return CharAt(index);
+        }
+
+        public int Mark() => -1;
+
+        public void Release(int marker)
+        {
+        }
+
+        public void Seek(int index)
+        {
+            _p = Math.Min(index, _size);
+        }
+
+        public string GetText(Interval interval)
+        {
+            if (_disposed) throw new ObjectDisposedException(SourceName);
+
+            var start = interval.a;
+            var stop = Math.Min(interval.b, _size - 1);
+            if (start >= _size || stop < start) return string.Empty;
+
+            return string.Create(stop - start + 1, (this, start), (chars, state) => state.Item1.CopyTo(state.start, chars));
+        }
+
+        private void CopyTo(int start, Span<char> chars)
+        {
+            var i = FindBlock(start);
+            while (chars.Length > 0)
+            {
+                var block = _blocks[i++];
+                var offset = start - block.CharStart;
+                var count = Math.Min(block.CharLength - offset, chars.Length);
+
+                if (block.Chars != null)
+                {
+                    block.Chars.AsSpan(offset, count).CopyTo(chars);
+                }
+                else
+                {
+                    Encoding.ASCII.GetChars(new ReadOnlySpan<byte>(_bytes + block.ByteStart + offset, count), chars);
+                }
+
+                chars = chars[count..];
+                start += count;
+            }
+        }
+
+        public override string ToString() => GetText(Interval.Of(0, _size - 1));
+
+        public void Dispose()
+        {
+            if (_disposed) return;
+            _disposed = true;
+            _size = 0;
+            _p = 0;
+
+            foreach (var block in _blocks)
+            {
+                if (block.Chars != null) ArrayPool<char>.Shared.Return(block.Chars);
+            }
+
+            if (_view != null)
+            {
+                _view.SafeMemoryMappedViewHandle.ReleasePointer();
+                _view.Dispose();
+                _file.Dispose();
+            }
+        }
+    }
+}
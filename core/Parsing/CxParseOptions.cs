@@ -0,0 +1,38 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public enum CxPredictionStrategy
+    {
+        LL, TwoStage
+    }
+
+    public enum CxErrorRecovery
+    {
+        // ANTLR's token-level recovery over the whole translation unit.
+        Default,
+        // Top-level declarations are parsed one at a time, and one that fails to parse is
+        // skipped up to the next `;` or `}` at brace depth 0.
+        Declaration
+    }
+
+    public class CxParseOptions
+    {
+        public CxPredictionStrategy PredictionStrategy { get; set; } = CxPredictionStrategy.TwoStage;
+        public bool SkipFunctionBodies { get; set; } = false;
+        // Lex into a CxTokenBuffer instead of a CommonTokenStream. Can't be combined with
+        // SkipFunctionBodies, which filters a token list; CxParserWorker rejects both.
+        public bool CompactTokens { get; set; } = false;
+        public CxErrorRecovery ErrorRecovery { get; set; } = CxErrorRecovery.Default;
+        // Once a budget is exceeded, the rest of the file is skipped and the declarations parsed
+        // so far are returned. Setting either one implies declaration-level recovery.
+        public TimeSpan TimeBudget { get; set; } = TimeSpan.Zero;
+        public int TokenBudget { get; set; } = 0;
+
+        internal bool ParsesDeclarations => ErrorRecovery == CxErrorRecovery.Declaration || TimeBudget > TimeSpan.Zero || TokenBudget > 0;
+    }
+}
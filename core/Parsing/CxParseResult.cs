@@ -0,0 +1,25 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public class CxParseResult
+    {
+        public string SourceName { get; init; }
+        public CPPCXParser.TranslationUnitContext TranslationUnit { get; init; }
+        public ITokenStream Tokens { get; init; }
+        public List<CxSyntaxError> SyntaxErrors { get; init; } = new List<CxSyntaxError>();
+        public Dictionary<int, SkippedFunctionBody> SkippedBodies { get; init; } = new Dictionary<int, SkippedFunctionBody>();
+        public List<CxSkippedRegion> SkippedRegions { get; init; } = new List<CxSkippedRegion>();
+        public CxPredictionStrategy PredictionStrategy { get; init; }
+        public bool UsedLlFallback { get; init; }
+        public TimeSpan Elapsed { get; init; }
+
+        public bool HasErrors => SyntaxErrors.Count > 0;
+        public bool BudgetExceeded => SkippedRegions.Any(o => o.Reason != CxSkipReason.SyntaxError);
+    }
+}
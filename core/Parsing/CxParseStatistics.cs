@@ -0,0 +1,34 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public class CxParseStatistics
+    {
+        private long _parses;
+        private long _sllParses;
+        private long _llFallbacks;
+
+        public long Parses => Interlocked.Read(ref _parses);
+        public long SllParses => Interlocked.Read(ref _sllParses);
+        public long LlFallbacks => Interlocked.Read(ref _llFallbacks);
+        public double SllHitRate => SllParses == 0 ? 0 : (double)(SllParses - LlFallbacks) / SllParses;
+
+        internal void Record(CxParseResult result)
+        {
+            Interlocked.Increment(ref _parses);
+            if (result.PredictionStrategy == CxPredictionStrategy.TwoStage)
+            {
+                Interlocked.Increment(ref _sllParses);
+            }
+            if (result.UsedLlFallback)
+            {
+                Interlocked.Increment(ref _llFallbacks);
+            }
+        }
+    }
+}
@@ -0,0 +1,113 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Reuses lexer/parser pairs across files and threads. The generated recognizers share one
+    // static DFA cache, so every pooled worker parses with the cache warmed by all others.
+    // The cache only grows; MaxDfaStates bounds it by clearing it between parses, together
+    // with the shared prediction context cache. Clearing waits for every parse in the process
+    // to finish, not only those of this pool, and is deferred when requested from inside a
+    // parse. Loading a snapshot from inside a parse throws InvalidOperationException.
+    public class CxParserPool
+    {
+        private readonly ConcurrentBag<CxParserWorker> _workers = new ConcurrentBag<CxParserWorker>();
+        private long _parses = 0;
+        private long _stableDfaParses = 0;
+        private long _clears = 0;
+        private int _created = 0;
+
+        public CxParseOptions Options { get; }
+        public int MaxDfaStates { get; init; } = 0;
+
+        public long Parses => Interlocked.Read(ref _parses);
+        // Parses during which the DFA cache didn't grow. The cache is global, so this only
+        // approximates cache hits while a single thread parses: a cold parse on another thread
+        // makes every parse overlapping it count as one that added states.
+        public long StableDfaParses => Interlocked.Read(ref _stableDfaParses);
+        public double StableDfaRate => Parses == 0 ? 0 : (double)StableDfaParses / Parses;
+        public long Clears => Interlocked.Read(ref _clears);
+        public int Workers => _created;
+        public static int DfaStates => CxDfaCache.CountStates();
+
+        public CxParserPool(CxParseOptions options = null)
+        {
+            Options = options ?? new CxParseOptions();
+        }
+
+        public CxParseResult ParseFile(string filename)
+        {
+            return Parse(CxSourceText.FromFile(filename));
+        }
+
+        public CxParseResult Parse(ICharStream input)
+        {
+            return Run(worker => worker.Parse(input), true);
+        }
+
+        public CxParseResult Parse(CxLexResult lexed)
+        {
+            return Run(worker => worker.Parse(lexed), true);
+        }
+
+        public CxLexResult Lex(ICharStream input)
+        {
+            return Run(worker => worker.Lex(input), false);
+        }
+
+        private T Run<T>(Func<CxParserWorker, T> action, bool isParse)
+        {
+            if (!_workers.TryTake(out var worker))
+            {
+                worker = new CxParserWorker(Options);
+                Interlocked.Increment(ref _created);
+            }
+
+            T res;
+            try
+            {
+                var states = DfaStates;
+                res = action(worker);
+
+                if (isParse)
+                {
+                    Interlocked.Increment(ref _parses);
+                    if (DfaStates == states) Interlocked.Increment(ref _stableDfaParses);
+                }
+            }
+            finally
+            {
+                _workers.Add(worker);
+            }
+
+            if (MaxDfaStates > 0 && DfaStates > MaxDfaStates)
+            {
+                ClearDfaCache();
+            }
+
+            return res;
+        }
+
+        public void ClearDfaCache()
+        {
+            CxDfaCache.Clear();
+            Interlocked.Increment(ref _clears);
+        }
+
+        public int LoadDfaSnapshot(string filename)
+        {
+            return CxDfaSnapshot.LoadFile(filename);
+        }
+
+        public void SaveDfaSnapshot(string filename)
+        {
+            CxDfaSnapshot.SaveFile(filename);
+        }
+    }
+}
@@ -0,0 +1,378 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Atn;
+using Antlr4.Runtime.Misc;
+using Antlr4.Runtime.Tree;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public class CxParserWorker
+    {
+        private class BudgetExceededException : Exception
+        {
+            public CxSkipReason Reason { get; }
+
+            public BudgetExceededException(CxSkipReason reason)
+            {
+                Reason = reason;
+            }
+        }
+
+        // Checked on rule entry, which is frequent enough to catch a single declaration that
+        // keeps the parser busy.
+        private class ParseBudget : IParseTreeListener
+        {
+            private readonly Parser _parser;
+            private readonly CxParseOptions _options;
+            private readonly Stopwatch _sw;
+            private int _rules = 0;
+
+            public ParseBudget(Parser parser, CxParseOptions options, Stopwatch sw)
+            {
+                _parser = parser;
+                _options = options;
+                _sw = sw;
+            }
+
+            public void EnterEveryRule(ParserRuleContext ctx)
+            {
+                if (_options.TokenBudget > 0 && _parser.CurrentToken.TokenIndex > _options.TokenBudget)
+                    throw new BudgetExceededException(CxSkipReason.TokenBudget);
+                if (_options.TimeBudget > TimeSpan.Zero && (++_rules & 63) == 0 && _sw.Elapsed > _options.TimeBudget)
+                    throw new BudgetExceededException(CxSkipReason.TimeBudget);
+            }
+
+            public void ExitEveryRule(ParserRuleContext ctx)
+            {
+            }
+
+            public void VisitErrorNode(IErrorNode node)
+            {
+            }
+
+            public void VisitTerminal(ITerminalNode node)
+            {
+            }
+        }
+
+        private readonly CxParseOptions _options;
+        // Created again once the shared DFA cache has been replaced, see CxDfaCache.
+        private CPPCXLexer _lexer;
+        private CPPCXParser _parser;
+        private int _generation = -1;
+        // Kept apart so that errors from a failed SLL attempt can be dropped without losing lexer
+        // errors raised while that attempt was reading ahead, which are not raised again.
+        private readonly SyntaxErrorCollector _lexerErrors = new SyntaxErrorCollector();
+        private readonly SyntaxErrorCollector _parserErrors = new SyntaxErrorCollector();
+
+        public CxParseStatistics Statistics { get; } = new CxParseStatistics();
+
+        public CxParserWorker(CxParseOptions options = null)
+        {
+            _options = options ?? new CxParseOptions();
+            if (_options.SkipFunctionBodies && _options.CompactTokens)
+            {
+                throw new ArgumentException($"{nameof(CxParseOptions.CompactTokens)} can't be combined with {nameof(CxParseOptions.SkipFunctionBodies)}", nameof(options));
+            }
+
+            CreateRecognizers();
+        }
+
+        private void CreateRecognizers()
+        {
+            if (_generation == CxDfaCache.Generation) return;
+            _generation = CxDfaCache.Generation;
+
+            _lexer = new CPPCXLexer(null);
+            _lexer.RemoveErrorListeners();
+            _lexer.AddErrorListener(_lexerErrors);
+
+            _parser = new CPPCXParser(null);
+            _parser.RemoveErrorListeners();
+            _parser.AddErrorListener(_parserErrors);
+            _parser.BuildParseTree = true;
+        }
+
+        public CxParseResult ParseFile(string filename)
+        {
+            return Parse(CxSourceText.FromFile(filename));
+        }
+
+        public CxParseResult Parse(ICharStream input)
+        {
+            return CxDfaCache.Read(() => ParseLocked(input));
+        }
+
+        // Lexes the whole input up front, so that another worker can parse the tokens.
+        public CxLexResult Lex(ICharStream input)
+        {
+            return CxDfaCache.Read(() => LexLocked(input));
+        }
+
+        public CxParseResult Parse(CxLexResult lexed)
+        {
+            return CxDfaCache.Read(() => ParseLocked(lexed));
+        }
+
+        private CxParseResult ParseLocked(ICharStream input)
+        {
+            var sw = Stopwatch.StartNew();
+            CreateRecognizers();
+            ClearErrors();
+
+            var skippedBodies = new Dictionary<int, SkippedFunctionBody>();
+            var tokens = CreateTokenStream(input, skippedBodies);
+            return Parse(input, tokens, skippedBodies, sw, TimeSpan.Zero);
+        }
+
+        private CxLexResult LexLocked(ICharStream input)
+        {
+            var sw = Stopwatch.StartNew();
+            CreateRecognizers();
+            ClearErrors();
+
+            var skippedBodies = new Dictionary<int, SkippedFunctionBody>();
+            var tokens = CreateTokenStream(input, skippedBodies);
+            if (tokens is BufferedTokenStream buffered) buffered.Fill();
+
+            return new CxLexResult
+            {
+                Input = input,
+                Tokens = tokens,
+                SkippedBodies = skippedBodies,
+                SyntaxErrors = _lexerErrors.Errors.ToList(),
+                Elapsed = sw.Elapsed,
+            };
+        }
+
+        private CxParseResult ParseLocked(CxLexResult lexed)
+        {
+            var sw = Stopwatch.StartNew();
+            CreateRecognizers();
+            ClearErrors();
+            _lexerErrors.Errors.AddRange(lexed.SyntaxErrors);
+
+            return Parse(lexed.Input, lexed.Tokens, lexed.SkippedBodies, sw, lexed.Elapsed);
+        }
+
+        private ITokenStream CreateTokenStream(ICharStream input, Dictionary<int, SkippedFunctionBody> skippedBodies)
+        {
+            _lexer.SetInputStream(input);
+            if (_options.SkipFunctionBodies)
+            {
+                return new CommonTokenStream(new ListTokenSource(FunctionBodySkipper.Skip(_lexer.GetAllTokens(), skippedBodies), input.SourceName));
+            }
+            if (_options.CompactTokens)
+            {
+                return CxTokenBuffer.Lex(_lexer, input);
+            }
+
+            return new CommonTokenStream(_lexer);
+        }
+
+        private CxParseResult Parse(ICharStream input, ITokenStream tokens, Dictionary<int, SkippedFunctionBody> skippedBodies, Stopwatch sw, TimeSpan lexTime)
+        {
+            CPPCXParser.TranslationUnitContext tu;
+            var fallback = false;
+            var skippedRegions = new List<CxSkippedRegion>();
+
+            if (_options.ParsesDeclarations)
+            {
+                tu = ParseDeclarations(input, tokens, sw, skippedRegions, out fallback);
+            }
+            else if (_options.PredictionStrategy == CxPredictionStrategy.TwoStage)
+            {
+                // SLL ignores the outer context and is much cheaper, but can report a syntax error
+                // for input that full LL accepts. Bail out on the first error and retry with LL,
+                // which also gives the usual error recovery and diagnostics for broken files.
+                try
+                {
+                    tu = ParseTranslationUnit(tokens, PredictionMode.SLL, new BailErrorStrategy());
+                }
+                catch (ParseCanceledException)
+                {
+                    // The rule that bailed out has already reported the error; LL reports it
+                    // again if the input really is broken.
+                    fallback = true;
+                    _parserErrors.Clear();
+                    tu = ParseTranslationUnit(tokens, PredictionMode.LL, new DefaultErrorStrategy());
+                }
+            }
+            else
+            {
+                tu = ParseTranslationUnit(tokens, PredictionMode.LL, new DefaultErrorStrategy());
+            }
+
+            var res = new CxParseResult
+            {
+                SourceName = input.SourceName,
+                TranslationUnit = tu,
+                Tokens = tokens,
+                SyntaxErrors = MergeErrors(),
+                SkippedBodies = skippedBodies,
+                SkippedRegions = skippedRegions,
+                PredictionStrategy = _options.PredictionStrategy,
+                UsedLlFallback = fallback,
+                Elapsed = lexTime + sw.Elapsed,
+            };
+
+            Statistics.Record(res);
+            return res;
+        }
+
+        private void ClearErrors()
+        {
+            _lexerErrors.Clear();
+            _parserErrors.Clear();
+        }
+
+        private List<CxSyntaxError> MergeErrors()
+        {
+            return _lexerErrors.Errors.Concat(_parserErrors.Errors).OrderBy(o => o.Line).ThenBy(o => o.Column).ToList();
+        }
+
+        private CPPCXParser.TranslationUnitContext ParseTranslationUnit(ITokenStream tokens, PredictionMode mode, IAntlrErrorStrategy errorStrategy)
+        {
+            tokens.Seek(0);
+            _parser.TokenStream = tokens;
+            _parser.ErrorHandler = errorStrategy;
+            _parser.Interpreter.PredictionMode = mode;
+            return _parser.translationUnit();
+        }
+
+        // Builds the translation unit from top-level declarations parsed one at a time, so one
+        // that fails to parse or exceeds a budget doesn't take the others with it.
+        private CPPCXParser.TranslationUnitContext ParseDeclarations(ICharStream input, ITokenStream tokens, Stopwatch sw, List<CxSkippedRegion> skippedRegions, out bool fallback)
+        {
+            fallback = false;
+            tokens.Seek(0);
+            _parser.TokenStream = tokens;
+            _parser.ErrorHandler = new BailErrorStrategy();
+
+            var tu = new CPPCXParser.TranslationUnitContext(null, -1) { Start = tokens.LT(1) };
+            var seq = new CPPCXParser.DeclarationseqContext(tu, 0) { Start = tokens.LT(1) };
+
+            var budget = new ParseBudget(_parser, _options, sw);
+            _parser.AddParseListener(budget);
+            try
+            {
+                while (tokens.LA(1) != TokenConstants.EOF)
+                {
+                    var start = tokens.Index;
+                    try
+                    {
+                        var declaration = ParseDeclaration(tokens, start, ref fallback);
+                        if (declaration != null)
+                        {
+                            seq.AddChild(declaration);
+                            declaration.Parent = seq;
+                        }
+                        else
+                        {
+                            skippedRegions.Add(SkipDeclaration(tokens, start));
+                        }
+                    }
+                    catch (BudgetExceededException e)
+                    {
+                        var first = tokens.Get(start);
+                        skippedRegions.Add(new CxSkippedRegion(new CxSourceSpan(first.StartIndex, input.Size - first.StartIndex), first.Line, first.Column, e.Reason));
+                        _parserErrors.Errors.Add(new CxSyntaxError(first.Line, first.Column, $"{(e.Reason == CxSkipReason.TimeBudget ? "time" : "token")} budget exceeded, skipped the rest of the file"));
+                        break;
+                    }
+                }
+            }
+            finally
+            {
+                _parser.RemoveParseListener(budget);
+            }
+
+            if (seq.ChildCount > 0)
+            {
+                seq.Start = ((ParserRuleContext)seq.GetChild(0)).Start;
+                seq.Stop = ((ParserRuleContext)seq.GetChild(seq.ChildCount - 1)).Stop;
+                tu.AddChild(seq);
+                tu.Stop = seq.Stop;
+            }
+            if (tokens.LA(1) == TokenConstants.EOF)
+            {
+                tu.AddChild(tokens.LT(1));
+                tu.Stop = tokens.LT(1);
+            }
+
+            return tu;
+        }
+
+        private CPPCXParser.DeclarationContext ParseDeclaration(ITokenStream tokens, int start, ref bool fallback)
+        {
+            // Parser errors reported before the bail strategy gives up are replaced by one for the
+            // skipped region. Lexer errors are collected separately and kept, since the retry reads
+            // tokens that are already buffered and doesn't raise them again.
+            var errors = _parserErrors.Errors.Count;
+
+            if (_options.PredictionStrategy == CxPredictionStrategy.TwoStage)
+            {
+                try
+                {
+                    _parser.ErrorHandler.Reset(_parser);
+                    _parser.Interpreter.PredictionMode = PredictionMode.SLL;
+                    return _parser.declaration();
+                }
+                catch (ParseCanceledException)
+                {
+                    fallback = true;
+                    _parserErrors.Errors.RemoveRange(errors, _parserErrors.Errors.Count - errors);
+                    tokens.Seek(start);
+                }
+            }
+
+            try
+            {
+                _parser.ErrorHandler.Reset(_parser);
+                _parser.Interpreter.PredictionMode = PredictionMode.LL;
+                return _parser.declaration();
+            }
+            catch (ParseCanceledException e)
+            {
+                var offending = (e.InnerException as RecognitionException)?.OffendingToken ?? tokens.LT(1);
+                _parserErrors.Errors.RemoveRange(errors, _parserErrors.Errors.Count - errors);
+                _parserErrors.Errors.Add(new CxSyntaxError(offending.Line, offending.Column, $"unexpected '{offending.Text}', skipped to the next declaration"));
+                tokens.Seek(start);
+                return null;
+            }
+        }
+
+        private static CxSkippedRegion SkipDeclaration(ITokenStream tokens, int start)
+        {
+            tokens.Seek(start);
+            var first = tokens.LT(1);
+            var last = first;
+            var depth = 0;
+
+            while (tokens.LA(1) != TokenConstants.EOF)
+            {
+                last = tokens.LT(1);
+                tokens.Consume();
+
+                if (last.Type == CPPCXLexer.Semi && depth == 0) break;
+                if (last.Type == CPPCXLexer.LeftBrace) ++depth;
+                if (last.Type == CPPCXLexer.RightBrace && --depth <= 0)
+                {
+                    // `class C { ... };`
+                    if (depth == 0 && tokens.LA(1) == CPPCXLexer.Semi)
+                    {
+                        last = tokens.LT(1);
+                        tokens.Consume();
+                    }
+                    break;
+                }
+            }
+
+            return new CxSkippedRegion(new CxSourceSpan(first.StartIndex, last.StopIndex - first.StartIndex + 1), first.Line, first.Column, CxSkipReason.SyntaxError);
+        }
+    }
+}
@@ -0,0 +1,19 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public enum CxSkipReason
+    {
+        SyntaxError, TimeBudget, TokenBudget
+    }
+
+    // Source left out of the parse tree by declaration-level recovery.
+    public record CxSkippedRegion(CxSourceSpan Span, int Line, int Column, CxSkipReason Reason)
+    {
+        public override string ToString() => $"line {Line}:{Column} skipped {Span.Length} chars ({Reason})";
+    }
+}
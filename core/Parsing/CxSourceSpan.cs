@@ -0,0 +1,54 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Text.Json.Serialization;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public readonly struct CxSourceSpan : IEquatable<CxSourceSpan>
+    {
+        public int Start { get; }
+        public int Length { get; }
+        [JsonIgnore]
+        public int End => Start + Length;
+        [JsonIgnore]
+        public bool IsEmpty => Length == 0;
+
+        [JsonConstructor]
+        public CxSourceSpan(int start, int length)
+        {
+            Start = start;
+            Length = length;
+        }
+
+        public static CxSourceSpan Of(IToken token)
+        {
+            if (token == null || token.StartIndex < 0) return default;
+            return new CxSourceSpan(token.StartIndex, Math.Max(0, token.StopIndex - token.StartIndex + 1));
+        }
+
+        public static CxSourceSpan Of(ParserRuleContext context)
+        {
+            var start = context?.Start;
+            if (start == null || start.StartIndex < 0) return default;
+
+            // Stop precedes Start for rules that matched nothing.
+            var stop = context.Stop ?? start;
+            return new CxSourceSpan(start.StartIndex, Math.Max(0, stop.StopIndex - start.StartIndex + 1));
+        }
+
+        public Interval ToInterval() => Interval.Of(Start, End - 1);
+
+        public bool Equals(CxSourceSpan other) => Start == other.Start && Length == other.Length;
+        public override bool Equals(object obj) => obj is CxSourceSpan other && Equals(other);
+        public override int GetHashCode() => HashCode.Combine(Start, Length);
+        public override string ToString() => $"[{Start}..{End})";
+
+        public static bool operator ==(CxSourceSpan left, CxSourceSpan right) => left.Equals(right);
+        public static bool operator !=(CxSourceSpan left, CxSourceSpan right) => !left.Equals(right);
+    }
+}
@@ -0,0 +1,100 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Security.Cryptography;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // A char stream over the original source text. Unlike CharStreams.fromPath it keeps the
+    // text as one string, so any token or rule range can be read back as a span without
+    // building a new string.
+    public sealed class CxSourceText : ICharStream
+    {
+        private string _text;
+        private int _p = 0;
+
+        public string SourceName { get; }
+        public ReadOnlyMemory<char> Memory => _text.AsMemory();
+        public int Index => _p;
+        public int Size => _text.Length;
+
+        public CxSourceText(string text, string sourceName = null)
+        {
+            _text = text ?? throw new ArgumentNullException(nameof(text));
+            SourceName = string.IsNullOrEmpty(sourceName) ? IntStreamConstants.UnknownSourceName : sourceName;
+        }
+
+        public static CxSourceText FromFile(string filename)
+        {
+            return new CxSourceText(File.ReadAllText(filename), filename);
+        }
+
+        // SHA-256 of the UTF-16 text, used to tell whether a file still has the text a model
+        // was built from.
+        public static string ComputeHash(ReadOnlySpan<char> text)
+        {
+            return Convert.ToHexString(SHA256.HashData(MemoryMarshal.AsBytes(text)));
+        }
+
+        public ReadOnlySpan<char> Slice(CxSourceSpan span)
+        {
+            return _text.AsSpan(span.Start, span.Length);
+        }
+
+        public ReadOnlyMemory<char> SliceMemory(CxSourceSpan span)
+        {
+            return _text.AsMemory(span.Start, span.Length);
+        }
+
+        // Only used by incremental re-parsing: tokens keep a reference to the stream they were
+        // lexed from, so the text is edited in place and their offsets are shifted instead.
+        internal void Replace(int start, int length, string text)
+        {
+            _text = string.Concat(_text.AsSpan(0, start), text.AsSpan(), _text.AsSpan(start + length));
+            _p = 0;
+        }
+
+        public void Consume()
+        {
+            if (_p >= _text.Length) throw new InvalidOperationException("cannot consume EOF");
+            ++_p;
+        }
+
+        public int LA(int i)
+        {
+            if (i == 0) return 0;
+            if (i < 0) ++i;
+
+            var index = _p + i - 1;
+            if (index < 0 || index >= _text.Length) return IntStreamConstants.EOF;
+            return _text[index];
+        }
+
+        public int Mark() => -1;
+
+        public void Release(int marker)
+        {
+        }
+
+        public void Seek(int index)
+        {
+            _p = Math.Min(index, _text.Length);
+        }
+
+        public string GetText(Interval interval)
+        {
+            var start = interval.a;
+            var stop = Math.Min(interval.b, _text.Length - 1);
+            if (start >= _text.Length || stop < start) return string.Empty;
+            return _text.Substring(start, stop - start + 1);
+        }
+
+        public override string ToString() => _text;
+    }
+}
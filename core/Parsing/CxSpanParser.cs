@@ -0,0 +1,70 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Re-parses a single rule from a range of a source file, e.g. a function body whose
+    // tree was dropped after the declarations were analyzed.
+    public static class CxSpanParser
+    {
+        public static ParserRuleContext Parse(CxSourceText source, CxSourceSpan span, int ruleIndex)
+        {
+            return CxDfaCache.Read(() => ParseLocked(source, span, ruleIndex));
+        }
+
+        private static ParserRuleContext ParseLocked(CxSourceText source, CxSourceSpan span, int ruleIndex)
+        {
+            var lexer = new CPPCXLexer(null);
+            lexer.RemoveErrorListeners();
+
+            var (line, column) = GetPosition(source, span.Start);
+            var tokens = Lex(lexer, source, span, line, column);
+
+            var parser = new CPPCXParser(new CommonTokenStream(new ListTokenSource(tokens, source.SourceName)));
+            parser.RemoveErrorListeners();
+
+            return ruleIndex switch
+            {
+                CPPCXParser.RULE_functionBody => (ParserRuleContext)parser.functionBody(),
+                CPPCXParser.RULE_compoundStatement => parser.compoundStatement(),
+                CPPCXParser.RULE_initializer => parser.initializer(),
+                CPPCXParser.RULE_braceOrEqualInitializer => parser.braceOrEqualInitializer(),
+                CPPCXParser.RULE_declaration => parser.declaration(),
+                _ => throw new ArgumentOutOfRangeException(nameof(ruleIndex), $"Rule {ruleIndex} can't be re-parsed from a span"),
+            };
+        }
+
+        internal static List<IToken> Lex(CPPCXLexer lexer, CxSourceText source, CxSourceSpan span, int line, int column)
+        {
+            lexer.SetInputStream(source);
+            source.Seek(span.Start);
+            lexer.Line = line;
+            lexer.Column = column;
+
+            var tokens = new List<IToken>();
+            for (var token = lexer.NextToken(); token.Type != TokenConstants.EOF && token.StartIndex < span.End; token = lexer.NextToken())
+            {
+                tokens.Add(token);
+            }
+
+            return tokens;
+        }
+
+        private static (int Line, int Column) GetPosition(CxSourceText source, int offset)
+        {
+            var prefix = source.Memory.Span[..offset];
+            var lastNewline = prefix.LastIndexOf('\n');
+            var line = 1;
+            foreach (var c in prefix)
+            {
+                if (c == '\n') ++line;
+            }
+
+            return (line, offset - lastNewline - 1);
+        }
+    }
+}
@@ -0,0 +1,13 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public record CxSyntaxError(int Line, int Column, string Message)
+    {
+        public override string ToString() => $"line {Line}:{Column} {Message}";
+    }
+}
@@ -0,0 +1,274 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Misc;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // A token stream that keeps default-channel tokens in parallel arrays instead of one
+    // CommonToken per token. It is the lexer's token factory while lexing, so the lexer
+    // allocates nothing per token; the parser gets a CxTokenView per token it actually looks
+    // at, and lookahead reads the type array directly. Hidden-channel tokens (directives,
+    // macros) are kept in a side table that can be dropped.
+    public sealed class CxTokenBuffer : ITokenStream, ITokenFactory
+    {
+        public readonly struct HiddenToken
+        {
+            public int Type { get; init; }
+            public int Channel { get; init; }
+            public int StartIndex { get; init; }
+            public int StopIndex { get; init; }
+            public int Line { get; init; }
+            public int Column { get; init; }
+            // Index of the default-channel token that follows it.
+            public int NextTokenIndex { get; init; }
+        }
+
+        private const int InitialCapacity = 1024;
+
+        private readonly ITokenSource _tokenSource;
+        private readonly ICharStream _input;
+        private readonly CommonToken _scratch = new CommonToken(TokenConstants.InvalidType);
+        private int[] _types = new int[InitialCapacity];
+        private int[] _starts = new int[InitialCapacity];
+        private int[] _stops = new int[InitialCapacity];
+        private int[] _lines = new int[InitialCapacity];
+        private int[] _columns = new int[InitialCapacity];
+        private CxTokenView[] _views;
+        private Dictionary<int, string> _texts = null;
+        private List<HiddenToken> _hidden = new List<HiddenToken>();
+        private int _count = 0;
+        private int _p = 0;
+
+        public ITokenSource TokenSource => _tokenSource;
+        public ICharStream InputStream => _input;
+        public string SourceName => _input.SourceName;
+        public int Index => _p;
+        public int Size => _count;
+        public IReadOnlyList<HiddenToken> HiddenTokens => _hidden;
+
+        private CxTokenBuffer(ITokenSource tokenSource, ICharStream input)
+        {
+            _tokenSource = tokenSource;
+            _input = input;
+        }
+
+        public static CxTokenBuffer Lex(Lexer lexer, ICharStream input)
+        {
+            var res = new CxTokenBuffer(lexer, input);
+
+            var factory = lexer.TokenFactory;
+            lexer.SetInputStream(input);
+            lexer.TokenFactory = res;
+            try
+            {
+                while (lexer.NextToken().Type != TokenConstants.EOF)
+                {
+                }
+            }
+            finally
+            {
+                // Tokens conjured by error recovery come from the lexer's factory.
+                lexer.TokenFactory = factory;
+            }
+
+            res._views = new CxTokenView[res._count];
+            return res;
+        }
+
+        IToken ITokenFactory.Create(Tuple<ITokenSource, ICharStream> source, int type, string text, int channel, int start, int stop, int line, int charPositionInLine)
+        {
+            if (channel != TokenConstants.DefaultChannel)
+            {
+                _hidden?.Add(new HiddenToken
+                {
+                    Type = type,
+                    Channel = channel,
+                    StartIndex = start,
+                    StopIndex = stop,
+                    Line = line,
+                    Column = charPositionInLine,
+                    NextTokenIndex = _count,
+                });
+            }
+            else
+            {
+                Add(type, text, start, stop, line, charPositionInLine);
+            }
+
+            _scratch.Type = type;
+            return _scratch;
+        }
+
+        IToken ITokenFactory.Create(int type, string text)
+        {
+            return new CommonToken(type, text);
+        }
+
+        private void Add(int type, string text, int start, int stop, int line, int column)
+        {
+            if (_count == _types.Length)
+            {
+                var capacity = _count * 2;
+                Array.Resize(ref _types, capacity);
+                Array.Resize(ref _starts, capacity);
+                Array.Resize(ref _stops, capacity);
+                Array.Resize(ref _lines, capacity);
+                Array.Resize(ref _columns, capacity);
+            }
+
+            if (text != null)
+            {
+                _texts ??= new Dictionary<int, string>();
+                _texts.Add(_count, text);
+            }
+
+            _types[_count] = type;
+            _starts[_count] = start;
+            _stops[_count] = stop;
+            _lines[_count] = line;
+            _columns[_count] = column;
+            ++_count;
+        }
+
+        public void DropHiddenTokens()
+        {
+            _hidden = null;
+        }
+
+        public IEnumerable<HiddenToken> GetHiddenTokensBefore(int tokenIndex)
+        {
+            if (_hidden == null) yield break;
+
+            // Hidden tokens are added in order, so NextTokenIndex never decreases.
+            int lo = 0, hi = _hidden.Count;
+            while (lo < hi)
+            {
+                var mid = lo + (hi - lo) / 2;
+                if (_hidden[mid].NextTokenIndex < tokenIndex) lo = mid + 1;
+                else hi = mid;
+            }
+
+            for (int i = lo; i < _hidden.Count && _hidden[i].NextTokenIndex == tokenIndex; ++i)
+            {
+                yield return _hidden[i];
+            }
+        }
+
+        internal int TypeAt(int index) => _types[index];
+        internal int StartIndexAt(int index) => _starts[index];
+        internal int StopIndexAt(int index) => _stops[index];
+        internal int LineAt(int index) => _lines[index];
+        internal int ColumnAt(int index) => _columns[index];
+
+        internal string TextAt(int index)
+        {
+            if (_texts != null && _texts.TryGetValue(index, out var text)) return text;
+            if (_types[index] == TokenConstants.EOF) return "<EOF>";
+
+            var start = _starts[index];
+            var stop = _stops[index];
+            return stop < start ? string.Empty : _input.GetText(Interval.Of(start, stop));
+        }
+
+        public IToken Get(int i)
+        {
+            if (i < 0 || i >= _count) throw new ArgumentOutOfRangeException(nameof(i));
+            return _views[i] ??= new CxTokenView(this, i);
+        }
+
+        public IToken LT(int k)
+        {
+            if (k == 0) return null;
+            var index = k > 0 ? _p + k - 1 : _p + k;
+            if (index < 0) return null;
+            return Get(Math.Min(index, _count - 1));
+        }
+
+        public int LA(int i)
+        {
+            if (i == 0) return 0;
+            var index = i > 0 ? _p + i - 1 : _p + i;
+            if (index < 0) return TokenConstants.InvalidType;
+            return _types[Math.Min(index, _count - 1)];
+        }
+
+        public void Consume()
+        {
+            if (LA(1) == TokenConstants.EOF) throw new InvalidOperationException("cannot consume EOF");
+            ++_p;
+        }
+
+        public int Mark() => -1;
+
+        public void Release(int marker)
+        {
+        }
+
+        public void Seek(int index)
+        {
+            _p = Math.Clamp(index, 0, _count - 1);
+        }
+
+        public string GetText()
+        {
+            return GetText(Interval.Of(0, _count - 1));
+        }
+
+        public string GetText(Interval interval)
+        {
+            var start = Math.Max(0, interval.a);
+            var stop = Math.Min(interval.b, _count - 1);
+
+            var sb = new StringBuilder();
+            for (int i = start; i <= stop && _types[i] != TokenConstants.EOF; ++i)
+            {
+                sb.Append(TextAt(i));
+            }
+            return sb.ToString();
+        }
+
+        public string GetText(RuleContext ctx)
+        {
+            return GetText(ctx.SourceInterval);
+        }
+
+        public string GetText(IToken start, IToken stop)
+        {
+            if (start == null || stop == null) return string.Empty;
+            return GetText(Interval.Of(start.TokenIndex, stop.TokenIndex));
+        }
+    }
+
+    public sealed class CxTokenView : IToken
+    {
+        private readonly CxTokenBuffer _buffer;
+        private readonly int _index;
+
+        internal CxTokenView(CxTokenBuffer buffer, int index)
+        {
+            _buffer = buffer;
+            _index = index;
+        }
+
+        public string Text => _buffer.TextAt(_index);
+        public int Type => _buffer.TypeAt(_index);
+        public int Line => _buffer.LineAt(_index);
+        public int Column => _buffer.ColumnAt(_index);
+        public int Channel => TokenConstants.DefaultChannel;
+        public int TokenIndex => _index;
+        public int StartIndex => _buffer.StartIndexAt(_index);
+        public int StopIndex => _buffer.StopIndexAt(_index);
+        public ITokenSource TokenSource => _buffer.TokenSource;
+        public ICharStream InputStream => _buffer.InputStream;
+
+        public override string ToString()
+        {
+            var text = Text?.Replace("\n", "\\n").Replace("\r", "\\r").Replace("\t", "\\t");
+            return $"[@{TokenIndex},{StartIndex}:{StopIndex}='{text}',<{Type}>,{Line}:{Column}]";
+        }
+    }
+}
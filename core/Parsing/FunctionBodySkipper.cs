@@ -0,0 +1,91 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public static class FunctionBodySkipper
+    {
+        private static readonly HashSet<int> _trailingQualifiers = new HashSet<int>
+        {
+            CPPCXLexer.Const, CPPCXLexer.Volatile, CPPCXLexer.Override, CPPCXLexer.Final,
+            CPPCXLexer.Sealed, CPPCXLexer.Noexcept, CPPCXLexer.And, CPPCXLexer.AndAnd,
+        };
+
+        // Replaces the contents of every brace block that directly follows a parameter list
+        // (optionally with trailing qualifiers) by nothing, so the parser sees `{ }`.
+        // That covers function bodies, lambda bodies and catch handlers, all of which stay
+        // valid compound statements. Class, namespace and enum bodies never follow a `)`.
+        public static List<IToken> Skip(IList<IToken> tokens, Dictionary<int, SkippedFunctionBody> skippedBodies)
+        {
+            var res = new List<IToken>(tokens.Count);
+
+            for (int i = 0; i < tokens.Count; ++i)
+            {
+                var token = tokens[i];
+                res.Add(token);
+
+                if (token.Channel != TokenConstants.DefaultChannel) continue;
+
+                if (token.Type == CPPCXLexer.LeftBrace && IsBodyStart(res, res.Count - 1))
+                {
+                    var end = FindMatchingBrace(tokens, i);
+                    if (end < 0) continue;
+
+                    var body = new SkippedFunctionBody
+                    {
+                        OpenBrace = token,
+                        CloseBrace = tokens[end],
+                    };
+                    for (int j = i + 1; j < end; ++j)
+                    {
+                        body.Tokens.Add(tokens[j]);
+                    }
+
+                    skippedBodies[token.StartIndex] = body;
+                    res.Add(tokens[end]);
+                    i = end;
+                }
+            }
+
+            return res;
+        }
+
+        private static bool IsBodyStart(List<IToken> emitted, int braceIndex)
+        {
+            for (int i = braceIndex - 1; i >= 0; --i)
+            {
+                var token = emitted[i];
+                if (token.Channel != TokenConstants.DefaultChannel) continue;
+                if (_trailingQualifiers.Contains(token.Type)) continue;
+                return token.Type == CPPCXLexer.RightParen;
+            }
+
+            return false;
+        }
+
+        private static int FindMatchingBrace(IList<IToken> tokens, int openIndex)
+        {
+            var depth = 0;
+            for (int i = openIndex; i < tokens.Count; ++i)
+            {
+                var token = tokens[i];
+                if (token.Channel != TokenConstants.DefaultChannel) continue;
+
+                if (token.Type == CPPCXLexer.LeftBrace)
+                {
+                    ++depth;
+                }
+                else if (token.Type == CPPCXLexer.RightBrace && --depth == 0)
+                {
+                    return i;
+                }
+            }
+
+            return -1;
+        }
+    }
+}
@@ -0,0 +1,94 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    // Interns names looked up by span, so repeated identifiers and type names share one
+    // string and a lookup of an existing name does not allocate.
+    public class NameTable
+    {
+        private class Entry
+        {
+            public readonly string Value;
+            public readonly int HashCode;
+            public Entry Next;
+
+            public Entry(string value, int hashCode, Entry next)
+            {
+                Value = value;
+                HashCode = hashCode;
+                Next = next;
+            }
+        }
+
+        private readonly object _lock = new object();
+        private Entry[] _buckets = new Entry[256];
+        private int _count = 0;
+
+        public int Count => _count;
+
+        public string Get(ParserRuleContext context)
+        {
+            return context == null ? null : Get(context.GetCodeMemory().Span);
+        }
+
+        public List<string> GetQualifiedNameParts(ParserRuleContext context, List<string> parts)
+        {
+            var span = context.GetCodeMemory().Span;
+            while (!span.IsEmpty)
+            {
+                var sep = span.IndexOf("::".AsSpan());
+                var part = (sep < 0 ? span : span[..sep]).Trim();
+                if (!part.IsEmpty) parts.Add(Get(part));
+                if (sep < 0) break;
+                span = span[(sep + 2)..];
+            }
+
+            return parts;
+        }
+
+        public string Get(ReadOnlySpan<char> name)
+        {
+            var hashCode = string.GetHashCode(name);
+            lock (_lock)
+            {
+                for (var entry = _buckets[hashCode & (_buckets.Length - 1)]; entry != null; entry = entry.Next)
+                {
+                    if (entry.HashCode == hashCode && name.SequenceEqual(entry.Value.AsSpan())) return entry.Value;
+                }
+
+                var value = name.ToString();
+                Add(value, hashCode);
+                return value;
+            }
+        }
+
+        private void Add(string value, int hashCode)
+        {
+            if (_count >= _buckets.Length)
+            {
+                var buckets = new Entry[_buckets.Length * 2];
+                foreach (var head in _buckets)
+                {
+                    for (var entry = head; entry != null;)
+                    {
+                        var next = entry.Next;
+                        var index = entry.HashCode & (buckets.Length - 1);
+                        entry.Next = buckets[index];
+                        buckets[index] = entry;
+                        entry = next;
+                    }
+                }
+                _buckets = buckets;
+            }
+
+            var bucket = hashCode & (_buckets.Length - 1);
+            _buckets[bucket] = new Entry(value, hashCode, _buckets[bucket]);
+            ++_count;
+        }
+    }
+}
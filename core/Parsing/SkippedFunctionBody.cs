@@ -0,0 +1,45 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public class SkippedFunctionBody
+    {
+        private readonly object _lock = new object();
+        private CPPCXParser.CompoundStatementContext _parsed;
+
+        public IToken OpenBrace { get; init; }
+        public IToken CloseBrace { get; init; }
+        public List<IToken> Tokens { get; init; } = new List<IToken>();
+        public List<CxSyntaxError> SyntaxErrors { get; } = new List<CxSyntaxError>();
+
+        public bool IsParsed => _parsed != null;
+
+        public CPPCXParser.CompoundStatementContext Parse()
+        {
+            lock (_lock)
+            {
+                if (_parsed != null) return _parsed;
+
+                // Braces are copied since the token stream assigns token indexes, and the
+                // originals are still referenced by the declarations-only tree.
+                var tokens = new List<IToken>(Tokens.Count + 2) { new CommonToken(OpenBrace) };
+                tokens.AddRange(Tokens);
+                tokens.Add(new CommonToken(CloseBrace));
+
+                var errors = new SyntaxErrorCollector();
+                var parser = new CPPCXParser(new CommonTokenStream(new ListTokenSource(tokens)));
+                parser.RemoveErrorListeners();
+                parser.AddErrorListener(errors);
+
+                _parsed = CxDfaCache.Read(parser.compoundStatement);
+                SyntaxErrors.AddRange(errors.Errors);
+                return _parsed;
+            }
+        }
+    }
+}
@@ -0,0 +1,105 @@
+﻿using Antlr4.Runtime;
+using Antlr4.Runtime.Tree;
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public static class SourceTextExtensions
+    {
+        // The original text covered by the rule, whitespace and comments included. Unlike
+        // GetText() this does not walk and concatenate the subtree, and does not allocate
+        // when the tree was parsed from a CxSourceText.
+        public static ReadOnlyMemory<char> GetSourceMemory(this ParserRuleContext context)
+        {
+            var span = CxSourceSpan.Of(context);
+            if (span.IsEmpty) return ReadOnlyMemory<char>.Empty;
+
+            var input = context.Start.InputStream;
+            if (input is CxSourceText source) return source.SliceMemory(span);
+            return (input?.GetText(span.ToInterval()) ?? string.Empty).AsMemory();
+        }
+
+        public static string GetSourceText(this ParserRuleContext context)
+        {
+            return context == null ? null : context.GetSourceMemory().ToString();
+        }
+
+        // The rule's default-channel tokens, separated by one space where the source has
+        // whitespace, comments or directives between them. This is the source text itself
+        // unless there is something to drop, in which case it is copied once.
+        public static ReadOnlyMemory<char> GetCodeMemory(this ParserRuleContext context)
+        {
+            var memory = context.GetSourceMemory();
+            if (memory.IsEmpty) return memory;
+
+            var offset = context.Start.StartIndex;
+            var previousStop = -1;
+            if (IsCode(context, memory.Span, offset, ref previousStop)) return memory;
+
+            var sb = new StringBuilder(memory.Length);
+            previousStop = -1;
+            AppendCode(context, memory.Span, offset, ref previousStop, sb);
+            return sb.ToString().AsMemory();
+        }
+
+        public static string GetCodeText(this ParserRuleContext context)
+        {
+            return context == null ? null : context.GetCodeMemory().ToString();
+        }
+
+        // Tokens of the subtree that come from the source. Tokens conjured by error recovery
+        // have no source range.
+        private static bool IsSourceToken(IToken token)
+        {
+            return token.StartIndex >= 0 && token.Type != TokenConstants.EOF;
+        }
+
+        // True when the tokens are at most one space apart, i.e. the source text already is the code.
+        private static bool IsCode(IParseTree tree, ReadOnlySpan<char> text, int offset, ref int previousStop)
+        {
+            if (tree is ITerminalNode terminal)
+            {
+                var token = terminal.Symbol;
+                if (!IsSourceToken(token)) return true;
+
+                if (previousStop >= 0)
+                {
+                    var gap = token.StartIndex - previousStop - 1;
+                    if (gap > 1 || (gap == 1 && text[previousStop + 1 - offset] != ' ')) return false;
+                }
+                previousStop = token.StopIndex;
+                return true;
+            }
+
+            for (int i = 0; i < tree.ChildCount; ++i)
+            {
+                if (!IsCode(tree.GetChild(i), text, offset, ref previousStop)) return false;
+            }
+
+            return true;
+        }
+
+        private static void AppendCode(IParseTree tree, ReadOnlySpan<char> text, int offset, ref int previousStop, StringBuilder sb)
+        {
+            if (tree is ITerminalNode terminal)
+            {
+                var token = terminal.Symbol;
+                if (!IsSourceToken(token)) return;
+
+                if (previousStop >= 0 && token.StartIndex > previousStop + 1) sb.Append(' ');
+                sb.Append(text[(token.StartIndex - offset)..(token.StopIndex + 1 - offset)]);
+                previousStop = token.StopIndex;
+                return;
+            }
+
+            for (int i = 0; i < tree.ChildCount; ++i)
+            {
+                AppendCode(tree.GetChild(i), text, offset, ref previousStop, sb);
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+﻿using Antlr4.Runtime;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Parsing
+{
+    public class SyntaxErrorCollector : IAntlrErrorListener<int>, IAntlrErrorListener<IToken>
+    {
+        public List<CxSyntaxError> Errors { get; } = new List<CxSyntaxError>();
+
+        public void SyntaxError(TextWriter output, IRecognizer recognizer, int offendingSymbol, int line, int charPositionInLine, string msg, RecognitionException e)
+        {
+            Errors.Add(new CxSyntaxError(line, charPositionInLine, msg));
+        }
+
+        public void SyntaxError(TextWriter output, IRecognizer recognizer, IToken offendingSymbol, int line, int charPositionInLine, string msg, RecognitionException e)
+        {
+            Errors.Add(new CxSyntaxError(line, charPositionInLine, msg));
+        }
+
+        public void Clear()
+        {
+            Errors.Clear();
+        }
+    }
+}
@@ -0,0 +1,35 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Serialization
+{
+    // Layout shared by CxModelWriter and CxModelReader:
+    //
+    //   header     "CXMB", version (int32)
+    //   records    namespaces and classes, each written after its children; child records
+    //              are referenced by their distance back from the parent record
+    //   strings    count, int32 offset per string, then length-prefixed UTF-8; id 0 is null
+    //   directory  count, then (name string id, record offset) per model
+    //   footer     strings offset (int64), directory offset (int64), "CXMB"
+    //
+    // Integers in records are unsigned LEB128 varints.
+    internal static class CxModelFormat
+    {
+        public const int Version = 3;
+        public const int HeaderSize = 8;
+        public const int FooterSize = 20;
+        public static readonly byte[] Magic = Encoding.ASCII.GetBytes("CXMB");
+
+        public const byte ClassSealed = 1;
+        public const byte ClassFinal = 2;
+
+        public const byte FunctionStatic = 1;
+        public const byte FunctionHasCode = 2;
+
+        public const byte MemberVirtual = 1;
+        public const byte MemberOverriden = 2;
+    }
+}
@@ -0,0 +1,374 @@
+﻿using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Buffers.Binary;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Serialization
+{
+    // Reads models written by CxModelWriter. Opening a file maps it and reads only the footer
+    // and the directory; a model is decoded when it is read, and strings are decoded once on
+    // first use. Reads don't modify the file state, so they can run on several threads.
+    public sealed unsafe class CxModelReader : IDisposable
+    {
+        private readonly MemoryMappedFile _file;
+        private readonly MemoryMappedViewAccessor _view;
+        private GCHandle _pin;
+        private readonly byte* _bytes;
+        private readonly long _length;
+        private readonly long _recordsEnd;
+        private readonly long _stringOffsets;
+        private readonly long _stringData;
+        private readonly string[] _strings;
+        private readonly (int Name, long Offset)[] _entries;
+        private bool _disposed = false;
+
+        public int Count
+        {
+            get
+            {
+                ThrowIfDisposed();
+                return _entries.Length;
+            }
+        }
+
+        // Decoded up front, so that the list stays valid once the reader is disposed.
+        public IReadOnlyList<string> Names
+        {
+            get
+            {
+                ThrowIfDisposed();
+                return _entries.Select(o => GetString(o.Name)).ToList();
+            }
+        }
+
+        private CxModelReader(MemoryMappedFile file, MemoryMappedViewAccessor view, GCHandle pin, byte* bytes, long length)
+        {
+            _file = file;
+            _view = view;
+            _pin = pin;
+            _bytes = bytes;
+            _length = length;
+
+            try
+            {
+                if (length < CxModelFormat.HeaderSize + CxModelFormat.FooterSize
+                    || !Span(0, 4).SequenceEqual(CxModelFormat.Magic)
+                    || !Span(length - 4, 4).SequenceEqual(CxModelFormat.Magic))
+                    throw new InvalidDataException("Not a model file");
+                if (BinaryPrimitives.ReadInt32LittleEndian(Span(4, 4)) != CxModelFormat.Version)
+                    throw new InvalidDataException("Unsupported model file version");
+
+                var pos = BinaryPrimitives.ReadInt64LittleEndian(Span(length - CxModelFormat.FooterSize, 8));
+                if (pos < CxModelFormat.HeaderSize || pos > length - CxModelFormat.FooterSize)
+                    throw new InvalidDataException("Invalid strings offset in model file");
+                _recordsEnd = pos;
+                _strings = new string[ReadInt(ref pos)];
+                _stringOffsets = pos;
+                _stringData = pos + 4L * _strings.Length;
+
+                pos = BinaryPrimitives.ReadInt64LittleEndian(Span(length - CxModelFormat.FooterSize + 8, 8));
+                _entries = new (int Name, long Offset)[ReadInt(ref pos)];
+                for (int i = 0; i < _entries.Length; ++i)
+                {
+                    _entries[i] = (ReadInt(ref pos), ReadLong(ref pos));
+                    if (!IsRecord(_entries[i].Offset)) throw new InvalidDataException("Invalid model offset in model file");
+                }
+            }
+            catch
+            {
+                Dispose();
+                throw;
+            }
+        }
+
+        public static CxModelReader Open(string filename)
+        {
+            var length = new FileInfo(filename).Length;
+            if (length == 0) throw new InvalidDataException("Not a model file");
+
+            var file = MemoryMappedFile.CreateFromFile(filename, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+            var view = file.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+
+            byte* ptr = null;
+            view.SafeMemoryMappedViewHandle.AcquirePointer(ref ptr);
+            return new CxModelReader(file, view, default, ptr + view.PointerOffset, length);
+        }
+
+        public static CxModelReader FromBytes(byte[] data)
+        {
+            var pin = GCHandle.Alloc(data, GCHandleType.Pinned);
+            return new CxModelReader(null, null, pin, (byte*)pin.AddrOfPinnedObject(), data.Length);
+        }
+
+        public string GetName(int index)
+        {
+            ThrowIfDisposed();
+            return GetString(_entries[index].Name);
+        }
+
+        public CxNamespace Read(int index)
+        {
+            ThrowIfDisposed();
+            return ReadNamespace(_entries[index].Offset);
+        }
+
+        // The last model added under the name, or null.
+        public CxNamespace Read(string name)
+        {
+            ThrowIfDisposed();
+            for (int i = _entries.Length - 1; i >= 0; --i)
+            {
+                if (GetName(i) == name) return Read(i);
+            }
+
+            return null;
+        }
+
+        public void Dispose()
+        {
+            if (_disposed) return;
+            _disposed = true;
+
+            if (_view != null)
+            {
+                _view.SafeMemoryMappedViewHandle.ReleasePointer();
+                _view.Dispose();
+                _file.Dispose();
+            }
+            if (_pin.IsAllocated)
+            {
+                _pin.Free();
+            }
+        }
+
+        // Every accessor checks, since the mapped view is gone once disposed.
+        private void ThrowIfDisposed()
+        {
+            if (_disposed) throw new ObjectDisposedException(nameof(CxModelReader));
+        }
+
+        private CxNamespace ReadNamespace(long offset)
+        {
+            var pos = offset;
+            var res = new CxNamespace { Namespace = ReadString(ref pos) ?? string.Empty };
+
+            foreach (var child in ReadChildren(offset, ref pos))
+            {
+                res.NestedNamespaces.Add(ReadNamespace(child));
+            }
+
+            for (int count = ReadInt(ref pos); count > 0; --count)
+            {
+                res.GlobalVariables.Add(new CxGlobalVariable
+                {
+                    TypedName = ReadTypedName(ref pos),
+                    InitValue = ReadString(ref pos),
+                    IsExtern = ReadByte(ref pos) != 0,
+                    Span = ReadSpan(ref pos),
+                });
+            }
+
+            for (int count = ReadInt(ref pos); count > 0; --count)
+            {
+                res.Functions.Add(ReadFunction(ref pos));
+            }
+
+            for (int count = ReadInt(ref pos); count > 0; --count)
+            {
+                res.UsingNamespaces.Add(ReadString(ref pos));
+            }
+
+            foreach (var child in ReadChildren(offset, ref pos))
+            {
+                res.Classes.Add(ReadClass(child));
+            }
+
+            return res;
+        }
+
+        private CxClass ReadClass(long offset)
+        {
+            var pos = offset;
+            var name = ReadString(ref pos);
+            var flags = ReadByte(ref pos);
+            var res = new CxClass
+            {
+                Name = name,
+                IsSealed = (flags & CxModelFormat.ClassSealed) != 0,
+                IsFinal = (flags & CxModelFormat.ClassFinal) != 0,
+                Span = ReadSpan(ref pos),
+            };
+
+            for (int count = ReadInt(ref pos); count > 0; --count)
+            {
+                var visibility = (CxVisibility)ReadByte(ref pos);
+                var memberFlags = ReadByte(ref pos);
+                res.Functions.Add(new CxMemberFunction
+                {
+                    Visibility = visibility,
+                    IsVirtual = (memberFlags & CxModelFormat.MemberVirtual) != 0,
+                    IsOverriden = (memberFlags & CxModelFormat.MemberOverriden) != 0,
+                    Function = ReadFunction(ref pos),
+                });
+            }
+
+            for (int count = ReadInt(ref pos); count > 0; --count)
+            {
+                res.Fields.Add(new CxField
+                {
+                    TypedName = ReadTypedName(ref pos),
+                    InitValue = ReadString(ref pos),
+                    Visibility = (CxVisibility)ReadByte(ref pos),
+                    IsStatic = ReadByte(ref pos) != 0,
+                });
+            }
+
+            foreach (var child in ReadChildren(offset, ref pos))
+            {
+                res.NestedClasses.Add(ReadClass(child));
+            }
+
+            return res;
+        }
+
+        private CxFunction ReadFunction(ref long pos)
+        {
+            var name = ReadString(ref pos);
+            var returnType = ReadType(ref pos);
+            var flags = ReadByte(ref pos);
+            var res = new CxFunction
+            {
+                Name = name,
+                ReturnType = returnType,
+                IsStatic = (flags & CxModelFormat.FunctionStatic) != 0,
+                Span = ReadSpan(ref pos),
+            };
+
+            for (int count = ReadInt(ref pos); count > 0; --count)
+            {
+                var typedName = ReadTypedName(ref pos);
+                res.Parameters.Add(new CxParameter(typedName, ReadString(ref pos)));
+            }
+
+            if ((flags & CxModelFormat.FunctionHasCode) != 0)
+            {
+                res.Code = new CxCode
+                {
+                    SourceName = ReadString(ref pos),
+                    Span = ReadSpan(ref pos),
+                    RuleIndex = ReadInt(ref pos) - 1,
+                    SourceLength = ReadInt(ref pos) - 1,
+                    SourceHash = ReadString(ref pos),
+                };
+            }
+
+            return res;
+        }
+
+        // Children are written before their parent, so each distance has to point back into
+        // the records. Anything else would make a corrupt file recurse forever.
+        private List<long> ReadChildren(long offset, ref long pos)
+        {
+            var count = ReadInt(ref pos);
+            if (count > _recordsEnd - pos) throw new InvalidDataException("Invalid child count in model file");
+
+            var res = new List<long>(count);
+            for (int i = 0; i < count; ++i)
+            {
+                var distance = ReadLong(ref pos);
+                if (distance <= 0 || !IsRecord(offset - distance)) throw new InvalidDataException("Invalid child offset in model file");
+                res.Add(offset - distance);
+            }
+
+            return res;
+        }
+
+        private bool IsRecord(long offset)
+        {
+            return offset >= CxModelFormat.HeaderSize && offset < _recordsEnd;
+        }
+
+        private CxType ReadType(ref long pos)
+        {
+            var id = ReadInt(ref pos);
+            return id == 0 ? null : new CxType(GetString(id - 1));
+        }
+
+        private CxTypedName ReadTypedName(ref long pos)
+        {
+            if (ReadByte(ref pos) == 0) return null;
+
+            var type = ReadType(ref pos);
+            return new CxTypedName(type, ReadString(ref pos));
+        }
+
+        private CxSourceSpan ReadSpan(ref long pos)
+        {
+            var start = ReadInt(ref pos);
+            return new CxSourceSpan(start, ReadInt(ref pos));
+        }
+
+        private string ReadString(ref long pos)
+        {
+            return GetString(ReadInt(ref pos));
+        }
+
+        private string GetString(int id)
+        {
+            if (id == 0) return null;
+            if ((uint)id >= (uint)_strings.Length) throw new InvalidDataException("Invalid string id in model file");
+
+            var res = _strings[id];
+            if (res != null) return res;
+
+            var pos = _stringData + BinaryPrimitives.ReadInt32LittleEndian(Span(_stringOffsets + 4L * id, 4));
+            var length = ReadInt(ref pos);
+            res = Encoding.UTF8.GetString(Span(pos, length));
+
+            // Racing readers decode the same string; either copy is fine.
+            _strings[id] = res;
+            return res;
+        }
+
+        private byte ReadByte(ref long pos)
+        {
+            if ((ulong)pos >= (ulong)_length) throw new InvalidDataException("Unexpected end of model file");
+            return _bytes[pos++];
+        }
+
+        private long ReadLong(ref long pos)
+        {
+            ulong res = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                var b = ReadByte(ref pos);
+                res |= (ulong)(b & 0x7F) << shift;
+                if ((b & 0x80) != 0) continue;
+                if (res > long.MaxValue) break;
+                return (long)res;
+            }
+
+            throw new InvalidDataException("Invalid varint in model file");
+        }
+
+        private int ReadInt(ref long pos)
+        {
+            var res = ReadLong(ref pos);
+            if (res > int.MaxValue) throw new InvalidDataException("Invalid varint in model file");
+            return (int)res;
+        }
+
+        private ReadOnlySpan<byte> Span(long offset, int length)
+        {
+            if (offset < 0 || length < 0 || offset + length > _length) throw new InvalidDataException("Unexpected end of model file");
+            return new ReadOnlySpan<byte>(_bytes + offset, length);
+        }
+    }
+}
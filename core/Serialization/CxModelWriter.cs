@@ -0,0 +1,299 @@
+﻿using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Buffers;
+using System.Buffers.Binary;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using System.Threading.Tasks;
+
+namespace cppcx.Core.Serialization
+{
+    // Writes models in the format read by CxModelReader. Every model is written out when it
+    // is added, so a batch can stream its results without keeping them; only the string table
+    // is held until Dispose writes it with the directory. Add can be called from any thread.
+    public sealed class CxModelWriter : IDisposable
+    {
+        private const int FlushSize = 64 * 1024;
+
+        private readonly object _lock = new object();
+        private readonly Stream _stream;
+        private readonly bool _leaveOpen;
+        private readonly ArrayBufferWriter<byte> _buffer = new ArrayBufferWriter<byte>(FlushSize * 2);
+        private readonly Dictionary<string, int> _stringIds = new Dictionary<string, int>(StringComparer.Ordinal);
+        private readonly List<string> _strings = new List<string> { null };
+        private readonly List<(int Name, long Offset)> _entries = new List<(int Name, long Offset)>();
+        private long _flushed = 0;
+        private bool _disposed = false;
+
+        public int Count => _entries.Count;
+
+        private long Position => _flushed + _buffer.WrittenCount;
+
+        public CxModelWriter(Stream stream, bool leaveOpen = false)
+        {
+            _stream = stream ?? throw new ArgumentNullException(nameof(stream));
+            _leaveOpen = leaveOpen;
+
+            WriteBytes(CxModelFormat.Magic);
+            BinaryPrimitives.WriteInt32LittleEndian(_buffer.GetSpan(4), CxModelFormat.Version);
+            _buffer.Advance(4);
+        }
+
+        public static CxModelWriter Create(string filename)
+        {
+            return new CxModelWriter(File.Create(filename));
+        }
+
+        public void Add(string name, CxNamespace model)
+        {
+            lock (_lock)
+            {
+                if (_disposed) throw new ObjectDisposedException(nameof(CxModelWriter));
+
+                var offset = WriteNamespace(model);
+                _entries.Add((GetStringId(name), offset));
+                if (_buffer.WrittenCount >= FlushSize) Flush();
+            }
+        }
+
+        public void Dispose()
+        {
+            lock (_lock)
+            {
+                if (_disposed) return;
+                _disposed = true;
+
+                var strings = Position;
+                WriteStrings();
+
+                var directory = Position;
+                WriteVarint(_entries.Count);
+                foreach (var (name, offset) in _entries)
+                {
+                    WriteVarint(name);
+                    WriteVarint(offset);
+                }
+
+                BinaryPrimitives.WriteInt64LittleEndian(_buffer.GetSpan(8), strings);
+                _buffer.Advance(8);
+                BinaryPrimitives.WriteInt64LittleEndian(_buffer.GetSpan(8), directory);
+                _buffer.Advance(8);
+                WriteBytes(CxModelFormat.Magic);
+
+                Flush();
+                _stream.Flush();
+                if (!_leaveOpen) _stream.Dispose();
+            }
+        }
+
+        private long WriteNamespace(CxNamespace ns)
+        {
+            var nested = ns.NestedNamespaces.Select(WriteNamespace).ToList();
+            var classes = ns.Classes.Select(WriteClass).ToList();
+
+            var offset = Position;
+            WriteString(ns.Namespace);
+            WriteChildren(offset, nested);
+
+            WriteVarint(ns.GlobalVariables.Count);
+            foreach (var variable in ns.GlobalVariables)
+            {
+                WriteTypedName(variable.TypedName);
+                WriteString(variable.InitValue);
+                WriteByte(variable.IsExtern ? (byte)1 : (byte)0);
+                WriteSpan(variable.Span);
+            }
+
+            WriteVarint(ns.Functions.Count);
+            foreach (var function in ns.Functions)
+            {
+                WriteFunction(function);
+            }
+
+            WriteVarint(ns.UsingNamespaces.Count);
+            foreach (var name in ns.UsingNamespaces)
+            {
+                WriteString(name);
+            }
+
+            WriteChildren(offset, classes);
+            return offset;
+        }
+
+        private long WriteClass(CxClass cls)
+        {
+            var nested = cls.NestedClasses.Select(WriteClass).ToList();
+
+            var offset = Position;
+            WriteString(cls.Name);
+            WriteByte((byte)((cls.IsSealed ? CxModelFormat.ClassSealed : 0) | (cls.IsFinal ? CxModelFormat.ClassFinal : 0)));
+            WriteSpan(cls.Span);
+
+            WriteVarint(cls.Functions.Count);
+            foreach (var member in cls.Functions)
+            {
+                WriteByte((byte)member.Visibility);
+                WriteByte((byte)((member.IsVirtual ? CxModelFormat.MemberVirtual : 0) | (member.IsOverriden ? CxModelFormat.MemberOverriden : 0)));
+                WriteFunction(member.Function);
+            }
+
+            WriteVarint(cls.Fields.Count);
+            foreach (var field in cls.Fields)
+            {
+                WriteTypedName(field.TypedName);
+                WriteString(field.InitValue);
+                WriteByte((byte)field.Visibility);
+                WriteByte(field.IsStatic ? (byte)1 : (byte)0);
+            }
+
+            WriteChildren(offset, nested);
+            return offset;
+        }
+
+        private void WriteFunction(CxFunction function)
+        {
+            WriteString(function.Name);
+            WriteType(function.ReturnType);
+            WriteByte((byte)((function.IsStatic ? CxModelFormat.FunctionStatic : 0) | (function.Code != null ? CxModelFormat.FunctionHasCode : 0)));
+            WriteSpan(function.Span);
+
+            WriteVarint(function.Parameters.Count);
+            foreach (var parameter in function.Parameters)
+            {
+                WriteTypedName(parameter.TypedName);
+                WriteString(parameter.DefaultValue);
+            }
+
+            if (function.Code != null)
+            {
+                WriteString(function.Code.SourceName);
+                WriteSpan(function.Code.Span);
+                WriteVarint(function.Code.RuleIndex + 1);
+                WriteVarint(function.Code.SourceLength + 1);
+                WriteString(function.Code.SourceHash);
+            }
+        }
+
+        private void WriteChildren(long offset, List<long> children)
+        {
+            WriteVarint(children.Count);
+            foreach (var child in children)
+            {
+                WriteVarint(offset - child);
+            }
+        }
+
+        // 0 is a null type, otherwise the name's string id + 1, since the name itself can be null.
+        private void WriteType(CxType type)
+        {
+            WriteVarint(type == null ? 0 : GetStringId(type.Name) + 1);
+        }
+
+        private void WriteTypedName(CxTypedName typedName)
+        {
+            if (typedName == null)
+            {
+                WriteByte(0);
+                return;
+            }
+
+            WriteByte(1);
+            WriteType(typedName.Type);
+            WriteString(typedName.Name);
+        }
+
+        private void WriteSpan(CxSourceSpan span)
+        {
+            WriteVarint(span.Start);
+            WriteVarint(span.Length);
+        }
+
+        private void WriteString(string value)
+        {
+            WriteVarint(GetStringId(value));
+        }
+
+        private int GetStringId(string value)
+        {
+            if (value == null) return 0;
+            if (_stringIds.TryGetValue(value, out var id)) return id;
+
+            id = _strings.Count;
+            _strings.Add(value);
+            _stringIds.Add(value, id);
+            return id;
+        }
+
+        private void WriteStrings()
+        {
+            WriteVarint(_strings.Count);
+
+            // Fixed-size offsets, so the reader can decode any single string on demand.
+            var offset = 0;
+            foreach (var value in _strings)
+            {
+                BinaryPrimitives.WriteInt32LittleEndian(_buffer.GetSpan(4), offset);
+                _buffer.Advance(4);
+
+                var length = value == null ? 0 : Encoding.UTF8.GetByteCount(value);
+                offset += GetVarintSize(length) + length;
+            }
+            if (_buffer.WrittenCount >= FlushSize) Flush();
+
+            foreach (var value in _strings)
+            {
+                var length = value == null ? 0 : Encoding.UTF8.GetByteCount(value);
+                WriteVarint(length);
+                if (length > 0)
+                {
+                    _buffer.Advance(Encoding.UTF8.GetBytes(value, _buffer.GetSpan(length)));
+                }
+                if (_buffer.WrittenCount >= FlushSize) Flush();
+            }
+        }
+
+        private void WriteByte(byte value)
+        {
+            _buffer.GetSpan(1)[0] = value;
+            _buffer.Advance(1);
+        }
+
+        private void WriteBytes(ReadOnlySpan<byte> bytes)
+        {
+            bytes.CopyTo(_buffer.GetSpan(bytes.Length));
+            _buffer.Advance(bytes.Length);
+        }
+
+        private void WriteVarint(long value)
+        {
+            if (value < 0) throw new ArgumentOutOfRangeException(nameof(value));
+
+            var span = _buffer.GetSpan(10);
+            var n = 0;
+            var v = (ulong)value;
+            for (; v >= 0x80; v >>= 7)
+            {
+                span[n++] = (byte)(v | 0x80);
+            }
+            span[n++] = (byte)v;
+            _buffer.Advance(n);
+        }
+
+        private static int GetVarintSize(int value)
+        {
+            var res = 1;
+            for (var v = (uint)value; v >= 0x80; v >>= 7) ++res;
+            return res;
+        }
+
+        private void Flush()
+        {
+            _stream.Write(_buffer.WrittenSpan);
+            _flushed += _buffer.WrittenCount;
+            _buffer.Clear();
+        }
+    }
+}
@@ -0,0 +1,134 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Diffing;
+using cppcx.Core.Models;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading.Tasks;
+
+namespace cppcx.CLI.Commands
+{
+    static class ApiDiffCommand
+    {
+        private const string Usage = "Usage: cppcx_parser api-diff [-j N] [--all] [--cache <dir>] <before dir|file> <after dir|file>";
+
+        public static int Run(string[] args)
+        {
+            var jobs = Environment.ProcessorCount;
+            var publicOnly = true;
+            string cacheDir = null;
+            var inputs = new List<string>();
+
+            try
+            {
+                for (int i = 0; i < args.Length; ++i)
+                {
+                    switch (args[i])
+                    {
+                        case "-j":
+                        case "--jobs":
+                            jobs = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--all":
+                            publicOnly = false;
+                            break;
+                        case "--cache":
+                            cacheDir = CommandArgs.GetValue(args, ref i);
+                            break;
+                        default:
+                            inputs.Add(args[i]);
+                            break;
+                    }
+                }
+            }
+            catch (UsageException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (inputs.Count != 2)
+            {
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            var pairs = Pair(inputs[0], inputs[1]);
+            var pool = new CxParserPool();
+            var cache = new CxHashCache(publicOnly, cacheDir);
+            var results = new (string Path, List<CxModelChange> Changes)[pairs.Count];
+            var unchanged = 0;
+
+            Parallel.For(0, pairs.Count, new ParallelOptions { MaxDegreeOfParallelism = jobs }, i =>
+            {
+                var (path, before, after) = pairs[i];
+
+                // Files with the same bytes can't differ, so they are not even parsed.
+                if (before != null && after != null && File.ReadAllBytes(before).AsSpan().SequenceEqual(File.ReadAllBytes(after)))
+                {
+                    System.Threading.Interlocked.Increment(ref unchanged);
+                    results[i] = (path, new List<CxModelChange>());
+                    return;
+                }
+
+                results[i] = (path, CxModelDiff.Compare(Hash(cache, pool, before), Hash(cache, pool, after)));
+            });
+
+            var changed = 0;
+            foreach (var (path, changes) in results.Where(o => o.Changes.Count > 0))
+            {
+                ++changed;
+                Console.WriteLine(path);
+                foreach (var change in changes)
+                {
+                    Console.WriteLine($"  {change}");
+                }
+            }
+
+            Console.WriteLine();
+            Console.WriteLine($"{pairs.Count} files, {unchanged} identical, {changed} with API changes, {cache.Misses} parsed");
+            return changed > 0 ? 3 : 0;
+        }
+
+        // Hash trees are cached by content, so with --cache only files changed since the last
+        // run are parsed.
+        private static CxHashNode Hash(CxHashCache cache, CxParserPool pool, string path)
+        {
+            if (path == null) return new CxModelHasher { PublicOnly = cache.PublicOnly }.Hash(new CxNamespace());
+
+            return cache.GetOrHash(path, source =>
+            {
+                var parsed = pool.Parse(source);
+                return new CxModelAnalyzer(parsed.SkippedBodies) { Detached = true }.Visit(parsed.TranslationUnit);
+            });
+        }
+
+        // Files are paired by their path relative to the two inputs; a file that exists on one
+        // side only is compared with an empty model.
+        private static List<(string Path, string Before, string After)> Pair(string before, string after)
+        {
+            if (!Directory.Exists(before) && !Directory.Exists(after))
+            {
+                return new List<(string, string, string)> { (after, File.Exists(before) ? before : null, File.Exists(after) ? after : null) };
+            }
+
+            var beforeFiles = Relative(before);
+            var afterFiles = Relative(after);
+            return beforeFiles.Keys.Union(afterFiles.Keys)
+                .OrderBy(o => o, StringComparer.Ordinal)
+                .Select(o => (o, beforeFiles.GetValueOrDefault(o), afterFiles.GetValueOrDefault(o)))
+                .ToList();
+        }
+
+        private static Dictionary<string, string> Relative(string dir)
+        {
+            if (!Directory.Exists(dir)) return new Dictionary<string, string>();
+
+            return SourceFiles.Expand(new[] { dir })
+                .ToDictionary(o => Path.GetRelativePath(dir, o), o => o, StringComparer.Ordinal);
+        }
+    }
+}
@@ -0,0 +1,242 @@
+﻿using cppcx.Core.Batch;
+using cppcx.Core.Caching;
+using cppcx.Core.Parsing;
+using cppcx.Core.Serialization;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+
+namespace cppcx.CLI.Commands
+{
+    static class BatchCommand
+    {
+        private const string Usage = "Usage: cppcx_parser batch [-j N] [--pipeline [--read-jobs N] [--lex-jobs N] [--parse-jobs N] [--analyze-jobs N] [--queue N]] [--prediction ll|two-stage] [--declarations-only] [--recover default|declarations] [--time-budget ms] [--token-budget N] [--compact-tokens] [--header-cache <dir>] [--mmap] [--models <file>] [--max-dfa-states N] [--dfa-snapshot <file>] [--save-dfa-snapshot <file>] [--parse-only] [-q] <dir|file|@list>...";
+
+        public static int Run(string[] args)
+        {
+            var options = new BatchPipeline.Options();
+            var quiet = false;
+            var pipeline = false;
+            var maxDfaStates = 0;
+            string dfaSnapshot = null;
+            string saveDfaSnapshot = null;
+            string models = null;
+            var inputs = new List<string>();
+
+            try
+            {
+                for (int i = 0; i < args.Length; ++i)
+                {
+                    switch (args[i])
+                    {
+                        case "-j":
+                        case "--jobs":
+                            options.MaxDegreeOfParallelism = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--pipeline":
+                            pipeline = true;
+                            break;
+                        case "--read-jobs":
+                            options.ReadParallelism = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--lex-jobs":
+                            options.LexParallelism = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--parse-jobs":
+                            options.ParseParallelism = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--analyze-jobs":
+                            options.AnalyzeParallelism = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--queue":
+                            options.QueueCapacity = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        case "--prediction":
+                            options.Parse.PredictionStrategy = CommandArgs.GetValue(args, ref i) switch
+                            {
+                                "ll" => CxPredictionStrategy.LL,
+                                "two-stage" => CxPredictionStrategy.TwoStage,
+                                _ => throw new UsageException($"Unknown prediction strategy: {args[i]}"),
+                            };
+                            break;
+                        case "--declarations-only":
+                            options.Parse.SkipFunctionBodies = true;
+                            break;
+                        case "--header-cache":
+                            options.HeaderCache = new HeaderModelCache(CommandArgs.GetValue(args, ref i));
+                            break;
+                        case "--recover":
+                            options.Parse.ErrorRecovery = CommandArgs.GetValue(args, ref i) switch
+                            {
+                                "default" => CxErrorRecovery.Default,
+                                "declarations" => CxErrorRecovery.Declaration,
+                                _ => throw new UsageException($"Unknown error recovery: {args[i]}"),
+                            };
+                            break;
+                        case "--time-budget":
+                            options.Parse.TimeBudget = TimeSpan.FromMilliseconds(CommandArgs.GetInt(args, ref i));
+                            break;
+                        case "--token-budget":
+                            options.Parse.TokenBudget = CommandArgs.GetInt(args, ref i);
+                            break;
+                        case "--compact-tokens":
+                            options.Parse.CompactTokens = true;
+                            break;
+                        case "--max-dfa-states":
+                            maxDfaStates = CommandArgs.GetInt(args, ref i);
+                            break;
+                        case "--dfa-snapshot":
+                            dfaSnapshot = CommandArgs.GetValue(args, ref i);
+                            break;
+                        case "--save-dfa-snapshot":
+                            saveDfaSnapshot = CommandArgs.GetValue(args, ref i);
+                            break;
+                        case "--models":
+                            models = CommandArgs.GetValue(args, ref i);
+                            break;
+                        case "--mmap":
+                            options.MapFiles = true;
+                            break;
+                        case "--parse-only":
+                            options.Analyze = false;
+                            break;
+                        case "-q":
+                        case "--quiet":
+                            quiet = true;
+                            break;
+                        default:
+                            inputs.Add(args[i]);
+                            break;
+                    }
+                }
+            }
+            catch (UsageException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (inputs.Count == 0)
+            {
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (options.Parse.SkipFunctionBodies && options.Parse.CompactTokens)
+            {
+                Console.Error.WriteLine("--compact-tokens has no effect with --declarations-only and is ignored");
+                options.Parse.CompactTokens = false;
+            }
+            // The pipeline reads files asynchronously into strings and parses every file itself.
+            if (pipeline && options.MapFiles)
+            {
+                Console.Error.WriteLine("--mmap has no effect with --pipeline and is ignored");
+                options.MapFiles = false;
+            }
+            if (pipeline && options.HeaderCache != null)
+            {
+                Console.Error.WriteLine("--header-cache has no effect with --pipeline and is ignored");
+                options.HeaderCache = null;
+            }
+
+            options.Pool = new CxParserPool(options.Parse) { MaxDfaStates = maxDfaStates };
+            if (models != null)
+            {
+                options.ModelOutput = CxModelWriter.Create(models);
+            }
+            if (dfaSnapshot != null && File.Exists(dfaSnapshot))
+            {
+                try
+                {
+                    var states = options.Pool.LoadDfaSnapshot(dfaSnapshot);
+                    if (!quiet) Console.WriteLine($"Loaded {states} DFA states from {dfaSnapshot}");
+                }
+                catch (InvalidDataException e)
+                {
+                    // A stale snapshot only costs warm-up time.
+                    Console.Error.WriteLine($"Ignoring DFA snapshot {dfaSnapshot}: {e.Message}");
+                }
+            }
+
+            var files = SourceFiles.Expand(inputs);
+            var consoleLock = new object();
+            Action<BatchRunner.FileResult> onFileCompleted = file =>
+            {
+                if (quiet && file.Exception == null) return;
+                lock (consoleLock)
+                {
+                    PrintFile(file);
+                }
+            };
+
+            var result = pipeline
+                ? new BatchPipeline(options).Run(files, onFileCompleted)
+                : new BatchRunner(options).Run(files, onFileCompleted);
+
+            options.ModelOutput?.Dispose();
+            PrintSummary(result, options);
+            if (saveDfaSnapshot != null)
+            {
+                options.Pool.SaveDfaSnapshot(saveDfaSnapshot);
+            }
+            return result.Files.Any(o => o.Exception != null) ? 2 : 0;
+        }
+
+        private static void PrintFile(BatchRunner.FileResult file)
+        {
+            if (file.Exception != null)
+            {
+                Console.Error.WriteLine($"{file.Elapsed.TotalMilliseconds,10:F1} ms  FAILED  {file.Path}: {file.Exception.Message}");
+                return;
+            }
+
+            Console.WriteLine($"{file.Elapsed.TotalMilliseconds,10:F1} ms {file.Bytes / 1024.0,10:F1} KB {file.Declarations,6} decls {file.SyntaxErrors,4} errors  {file.Path}{(file.BudgetExceeded ? "  (over budget)" : "")}");
+        }
+
+        private static void PrintSummary(BatchRunner.Result result, BatchRunner.Options options)
+        {
+            Console.WriteLine();
+            Console.WriteLine($"Files:       {result.Files.Count} ({result.Files.Count(o => o.Exception != null)} failed, {result.Files.Count(o => o.SyntaxErrors > 0)} with syntax errors)");
+            Console.WriteLine($"Input:       {result.TotalBytes / (1024.0 * 1024.0):F2} MB");
+            if (result is not BatchPipeline.Result)
+            {
+                Console.WriteLine($"Workers:     {options.MaxDegreeOfParallelism}");
+            }
+            Console.WriteLine($"Wall time:   {result.WallTime.TotalSeconds:F3} s");
+            Console.WriteLine($"Worker time: {result.TotalFileTime.TotalSeconds:F3} s");
+            if (options.Parse.PredictionStrategy == CxPredictionStrategy.TwoStage && result.Files.Count > 0)
+            {
+                var sllHits = result.Files.Count - result.LlFallbacks;
+                Console.WriteLine($"SLL hits:    {sllHits}/{result.Files.Count} ({100.0 * sllHits / result.Files.Count:F1}%), {result.LlFallbacks} LL fallbacks");
+            }
+            if (result.SkippedRegions > 0)
+            {
+                Console.WriteLine($"Skipped:     {result.SkippedRegions} regions, {result.BudgetsExceeded} files over budget");
+            }
+            if (options.HeaderCache != null)
+            {
+                Console.WriteLine($"Headers:     {options.HeaderCache.Hits} cached ({options.HeaderCache.DiskHits} from disk), {options.HeaderCache.Misses} parsed");
+            }
+            Console.WriteLine($"DFA cache:   {CxParserPool.DfaStates} states, {options.Pool.StableDfaParses}/{options.Pool.Parses} parses without new states, {options.Pool.Clears} clears, {options.Pool.Workers} parsers");
+            Console.WriteLine($"Throughput:  {result.FilesPerSecond:F1} files/s, {result.MegabytesPerSecond:F2} MB/s");
+
+            if (result is BatchPipeline.Result pipelined)
+            {
+                PrintStages(pipelined);
+            }
+        }
+
+        private static void PrintStages(BatchPipeline.Result result)
+        {
+            // The bottleneck is the busiest stage; the ones before it are blocked on its queue.
+            Console.WriteLine();
+            Console.WriteLine($"{"stage",-8} {"jobs",4} {"files",6} {"busy s",8} {"blocked s",9} {"util",6} {"queue avg/max",13}");
+            foreach (var o in result.Stages)
+            {
+                Console.WriteLine($"{o.Name,-8} {o.Parallelism,4} {o.Items,6} {o.BusyTime.TotalSeconds,8:F2} {o.BlockedTime.TotalSeconds,9:F2} {o.Utilization(result.WallTime),6:P0} {$"{o.AverageQueueLength:F1}/{o.MaxQueueLength}",13}");
+            }
+        }
+    }
+}
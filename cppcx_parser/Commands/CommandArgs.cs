@@ -0,0 +1,33 @@
+﻿using System;
+using System.Globalization;
+
+namespace cppcx.CLI.Commands
+{
+    // A missing or malformed option value. Commands print it followed by their usage line.
+    class UsageException : Exception
+    {
+        public UsageException(string message) : base(message)
+        {
+        }
+    }
+
+    static class CommandArgs
+    {
+        // The value following the option at args[i], advancing i past it.
+        public static string GetValue(string[] args, ref int i)
+        {
+            var option = args[i];
+            if (++i >= args.Length) throw new UsageException($"Missing value for {option}");
+            return args[i];
+        }
+
+        public static int GetInt(string[] args, ref int i, int min = 0)
+        {
+            var option = args[i];
+            var value = GetValue(args, ref i);
+            if (!int.TryParse(value, NumberStyles.Integer, CultureInfo.InvariantCulture, out var res) || res < min)
+                throw new UsageException($"Invalid value for {option}: {value}");
+            return res;
+        }
+    }
+}
@@ -0,0 +1,202 @@
+﻿using cppcx.Core.Analyzers;
+using cppcx.Core.Indexing;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading.Tasks;
+
+namespace cppcx.CLI.Commands
+{
+    static class IndexCommand
+    {
+        private const string Usage = "Usage: cppcx_parser index --index <file> [--identifiers] [-j N] [--lookup qualified::name]... [<dir|file|@list>...]";
+
+        public static int Run(string[] args)
+        {
+            string indexFile = null;
+            var jobs = Environment.ProcessorCount;
+            var identifiers = false;
+            var lookups = new List<string>();
+            var inputs = new List<string>();
+
+            try
+            {
+                for (int i = 0; i < args.Length; ++i)
+                {
+                    switch (args[i])
+                    {
+                        case "--index":
+                            indexFile = CommandArgs.GetValue(args, ref i);
+                            break;
+                        case "--lookup":
+                            lookups.Add(CommandArgs.GetValue(args, ref i));
+                            break;
+                        case "--identifiers":
+                            identifiers = true;
+                            break;
+                        case "-j":
+                        case "--jobs":
+                            jobs = CommandArgs.GetInt(args, ref i, min: 1);
+                            break;
+                        default:
+                            inputs.Add(args[i]);
+                            break;
+                    }
+                }
+            }
+            catch (UsageException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (indexFile == null || (inputs.Count == 0 && lookups.Count == 0))
+            {
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (identifiers)
+            {
+                return RunIdentifiers(indexFile, inputs, lookups, jobs);
+            }
+
+            var index = new CxSymbolIndex();
+            if (File.Exists(indexFile))
+            {
+                try
+                {
+                    index = CxSymbolIndex.LoadFile(indexFile);
+                }
+                catch (InvalidDataException e)
+                {
+                    Console.Error.WriteLine($"Rebuilding {indexFile}: {e.Message}");
+                }
+            }
+
+            if (inputs.Count > 0)
+            {
+                var failed = Update(index, SourceFiles.Expand(inputs), jobs);
+                index.SaveFile(indexFile);
+                if (failed > 0) return 2;
+            }
+
+            foreach (var name in lookups)
+            {
+                PrintSymbol(index, name);
+            }
+
+            return 0;
+        }
+
+        // Only files that changed since the last run are parsed again, and files that no longer
+        // exist are dropped.
+        private static int Update(CxSymbolIndex index, List<string> files, int jobs)
+        {
+            foreach (var path in index.Files.Where(o => !File.Exists(o)))
+            {
+                index.Remove(path);
+            }
+
+            var stale = files.Where(o => !index.IsUpToDate(o)).ToList();
+            var pool = new CxParserPool();
+            var failed = 0;
+
+            Parallel.ForEach(stale, new ParallelOptions { MaxDegreeOfParallelism = jobs }, file =>
+            {
+                try
+                {
+                    var source = CxSourceText.FromFile(file);
+                    var parsed = pool.Parse(source);
+                    var model = new CxModelAnalyzer(parsed.SkippedBodies) { Detached = true }.Visit(parsed.TranslationUnit);
+                    index.Update(file, model, source);
+                }
+                catch (Exception e)
+                {
+                    System.Threading.Interlocked.Increment(ref failed);
+                    Console.Error.WriteLine($"FAILED  {file}: {e.Message}");
+                }
+            });
+
+            Console.WriteLine($"Indexed {stale.Count} of {files.Count} files ({files.Count - stale.Count} up to date), {index.Count} symbols");
+            return failed;
+        }
+
+        // The identifier index only lexes files; lookups list every token of the name in the
+        // files that contain all of its parts.
+        private static int RunIdentifiers(string indexFile, List<string> inputs, List<string> lookups, int jobs)
+        {
+            var index = new CxIdentifierIndex();
+            if (File.Exists(indexFile))
+            {
+                try
+                {
+                    index = CxIdentifierIndex.LoadFile(indexFile);
+                }
+                catch (InvalidDataException e)
+                {
+                    Console.Error.WriteLine($"Rebuilding {indexFile}: {e.Message}");
+                }
+            }
+
+            if (inputs.Count > 0)
+            {
+                var files = SourceFiles.Expand(inputs);
+                foreach (var path in index.Files.Where(o => !File.Exists(o)))
+                {
+                    index.Remove(path);
+                }
+
+                var stale = files.Where(o => !index.IsUpToDate(o)).ToList();
+                var failed = 0;
+                Parallel.ForEach(stale, new ParallelOptions { MaxDegreeOfParallelism = jobs }, file =>
+                {
+                    try
+                    {
+                        index.Update(file);
+                    }
+                    catch (Exception e)
+                    {
+                        System.Threading.Interlocked.Increment(ref failed);
+                        Console.Error.WriteLine($"FAILED  {file}: {e.Message}");
+                    }
+                });
+
+                Console.WriteLine($"Indexed {stale.Count} of {files.Count} files ({files.Count - stale.Count} up to date), {index.Count} identifiers");
+                index.SaveFile(indexFile);
+                if (failed > 0) return 2;
+            }
+
+            foreach (var name in lookups)
+            {
+                var occurrences = index.Find(name);
+                Console.WriteLine($"{name}: {occurrences.Count} occurrences in {index.FindFiles(name).Count} files");
+                foreach (var (occurrence, line, column) in CxIdentifierIndex.Locate(occurrences))
+                {
+                    Console.WriteLine($"  {occurrence.Path}({line},{column + 1})");
+                }
+            }
+
+            return 0;
+        }
+
+        private static void PrintSymbol(CxSymbolIndex index, string name)
+        {
+            var id = index.Find(name);
+            if (id < 0)
+            {
+                Console.WriteLine($"{name}: not found");
+                return;
+            }
+
+            Console.WriteLine($"{index.GetQualifiedName(id)} ({index.GetKind(id)})");
+            foreach (var location in index.GetLocations(id).OrderBy(o => o.Path, StringComparer.Ordinal).ThenBy(o => o.Line))
+            {
+                Console.WriteLine($"  {(location.IsDefinition ? "definition " : "declaration")}  {location}");
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+﻿using cppcx.Core.Helpers;
+using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+
+namespace cppcx.CLI.Commands
+{
+    static class PrintCommand
+    {
+        private const string Usage = "Usage: cppcx_parser print [--text none|tokens|truncated|full] [--max-text N] [--depth N] [--rule name]... [-o <file>] <file>";
+
+        public static int Run(string[] args)
+        {
+            var text = CPPCXPrinterText.Truncated;
+            var maxText = 80;
+            var maxDepth = int.MaxValue;
+            HashSet<int> rules = null;
+            string output = null;
+            string input = null;
+
+            try
+            {
+                for (int i = 0; i < args.Length; ++i)
+                {
+                    switch (args[i])
+                    {
+                        case "--text":
+                            text = CommandArgs.GetValue(args, ref i) switch
+                            {
+                                "none" => CPPCXPrinterText.None,
+                                "tokens" => CPPCXPrinterText.Tokens,
+                                "truncated" => CPPCXPrinterText.Truncated,
+                                "full" => CPPCXPrinterText.Full,
+                                _ => throw new UsageException($"Unknown text mode: {args[i]}"),
+                            };
+                            break;
+                        case "--max-text":
+                            maxText = CommandArgs.GetInt(args, ref i);
+                            break;
+                        case "--depth":
+                            maxDepth = CommandArgs.GetInt(args, ref i);
+                            break;
+                        case "--rule":
+                            var rule = Array.IndexOf(CPPCXParser.ruleNames, CommandArgs.GetValue(args, ref i));
+                            if (rule < 0) throw new UsageException($"Unknown rule: {args[i]}");
+                            (rules ??= new HashSet<int>()).Add(rule);
+                            break;
+                        case "-o":
+                        case "--output":
+                            output = CommandArgs.GetValue(args, ref i);
+                            break;
+                        default:
+                            input = args[i];
+                            break;
+                    }
+                }
+            }
+            catch (UsageException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (input == null)
+            {
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            var parsed = new CxParserWorker().ParseFile(input);
+            foreach (var error in parsed.SyntaxErrors)
+            {
+                Console.Error.WriteLine($"{input}: {error}");
+            }
+
+            using var writer = output != null
+                ? new StreamWriter(output)
+                : new StreamWriter(Console.OpenStandardOutput());
+            new CPPCXPrinter(writer)
+            {
+                Text = text,
+                MaxTextLength = maxText,
+                MaxDepth = maxDepth,
+                Rules = rules,
+            }.Print(parsed.TranslationUnit);
+
+            return 0;
+        }
+    }
+}
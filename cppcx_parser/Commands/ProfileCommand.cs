@@ -0,0 +1,103 @@
+﻿using cppcx.Core.Parsing;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+
+namespace cppcx.CLI.Commands
+{
+    static class ProfileCommand
+    {
+        private const string Usage = "Usage: cppcx_parser profile [--top N] [--csv <file>] [--json <file>] <dir|file|@list>...";
+
+        public static int Run(string[] args)
+        {
+            string csv = null;
+            string json = null;
+            var top = 20;
+            var inputs = new List<string>();
+
+            try
+            {
+                for (int i = 0; i < args.Length; ++i)
+                {
+                    switch (args[i])
+                    {
+                        case "--csv":
+                            csv = CommandArgs.GetValue(args, ref i);
+                            break;
+                        case "--json":
+                            json = CommandArgs.GetValue(args, ref i);
+                            break;
+                        case "--top":
+                            top = CommandArgs.GetInt(args, ref i);
+                            break;
+                        default:
+                            inputs.Add(args[i]);
+                            break;
+                    }
+                }
+            }
+            catch (UsageException e)
+            {
+                Console.Error.WriteLine(e.Message);
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            if (inputs.Count == 0)
+            {
+                Console.Error.WriteLine(Usage);
+                return 1;
+            }
+
+            var profiler = new CxDecisionProfiler();
+            foreach (var file in SourceFiles.Expand(inputs))
+            {
+                try
+                {
+                    var res = profiler.ParseFile(file);
+                    Console.WriteLine($"{res.Elapsed.TotalMilliseconds,10:F1} ms {res.SyntaxErrors.Count,4} errors  {file}");
+                }
+                catch (Exception e)
+                {
+                    Console.Error.WriteLine($"FAILED  {file}: {e.Message}");
+                }
+            }
+
+            var decisions = profiler.GetDecisions();
+            if (csv != null)
+            {
+                using var writer = new StreamWriter(csv);
+                CxDecisionProfiler.WriteCsv(writer, decisions);
+            }
+            if (json != null)
+            {
+                using var stream = File.Create(json);
+                CxDecisionProfiler.WriteJson(stream, decisions);
+            }
+
+            PrintReport(profiler, decisions, top);
+            return 0;
+        }
+
+        private static void PrintReport(CxDecisionProfiler profiler, List<CxDecisionProfiler.DecisionStats> decisions, int top)
+        {
+            Console.WriteLine();
+            Console.WriteLine($"Rules by prediction time ({profiler.Files} files):");
+            Console.WriteLine($"{"rule",-32} {"decisions",9} {"invocations",12} {"time ms",10} {"LL fallbacks",12} {"ambiguities",11}");
+            foreach (var o in profiler.GetRules().Take(top))
+            {
+                Console.WriteLine($"{o.Rule,-32} {o.Decisions,9} {o.Invocations,12} {o.TimeMs,10:F1} {o.LlFallbacks,12} {o.Ambiguities,11}");
+            }
+
+            Console.WriteLine();
+            Console.WriteLine("Decisions by prediction time:");
+            Console.WriteLine($"{"decision",8} {"rule",-32} {"invocations",12} {"time ms",10} {"SLL avg/max",12} {"LL fallbacks",12} {"LL avg/max",12} {"ambiguities",11}");
+            foreach (var o in decisions.Take(top))
+            {
+                Console.WriteLine($"{o.Decision,8} {o.Rule,-32} {o.Invocations,12} {o.TimeMs,10:F1} {$"{o.AverageSllLook:F1}/{o.SllMaxLook}",12} {o.LlFallbacks,12} {$"{o.AverageLlLook:F1}/{o.LlMaxLook}",12} {o.Ambiguities,11}");
+            }
+        }
+    }
+}
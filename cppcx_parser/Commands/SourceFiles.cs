@@ -0,0 +1,43 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+
+namespace cppcx.CLI.Commands
+{
+    static class SourceFiles
+    {
+        private static readonly HashSet<string> _extensions = new HashSet<string>(StringComparer.OrdinalIgnoreCase)
+        {
+            ".cpp", ".cxx", ".cc", ".c", ".h", ".hpp", ".hxx", ".inl",
+        };
+
+        public static bool IsSourceFile(string path) => _extensions.Contains(Path.GetExtension(path));
+
+        // Accepts directories (searched recursively), plain files and @list files
+        // containing one path per line.
+        public static List<string> Expand(IEnumerable<string> inputs)
+        {
+            var res = new List<string>();
+            foreach (var input in inputs)
+            {
+                if (input.StartsWith('@'))
+                {
+                    res.AddRange(File.ReadLines(input[1..])
+                        .Select(o => o.Trim())
+                        .Where(o => o.Length > 0 && !o.StartsWith('#')));
+                }
+                else if (Directory.Exists(input))
+                {
+                    res.AddRange(Directory.EnumerateFiles(input, "*", SearchOption.AllDirectories).Where(IsSourceFile));
+                }
+                else
+                {
+                    res.Add(input);
+                }
+            }
+
+            return res.Distinct(StringComparer.Ordinal).ToList();
+        }
+    }
+}
@@ -1,12 +1,53 @@
-﻿using System;
+﻿using cppcx.CLI.Commands;
+using System;
 
 namespace cppcx.CLI
 {
     class Program
     {
-        static void Main(string[] args)
+        static int Main(string[] args)
         {
-            Console.WriteLine("Hello World!");
+            if (args.Length == 0)
+            {
+                PrintUsage();
+                return 1;
+            }
+
+            var rest = args[1..];
+            switch (args[0])
+            {
+                case "api-diff":
+                    return ApiDiffCommand.Run(rest);
+                case "batch":
+                    return BatchCommand.Run(rest);
+                case "profile":
+                    return ProfileCommand.Run(rest);
+                case "index":
+                    return IndexCommand.Run(rest);
+                case "print":
+                    return PrintCommand.Run(rest);
+                case "-h":
+                case "--help":
+                case "help":
+                    PrintUsage();
+                    return 0;
+                default:
+                    Console.Error.WriteLine($"Unknown command: {args[0]}");
+                    PrintUsage();
+                    return 1;
+            }
+        }
+
+        static void PrintUsage()
+        {
+            Console.WriteLine("Usage: cppcx_parser <command> [options]");
+            Console.WriteLine();
+            Console.WriteLine("Commands:");
+            Console.WriteLine("  api-diff <before> <after>   Compare the declarations of two revisions");
+            Console.WriteLine("  batch <dir|file|@list>...   Parse and analyze source files in parallel");
+            Console.WriteLine("  profile <dir|file|@list>... Report the prediction cost of each grammar decision");
+            Console.WriteLine("  index <dir|file|@list>...   Build or update a symbol index and look up names");
+            Console.WriteLine("  print <file>                Print the parse tree of a file");
         }
     }
 }